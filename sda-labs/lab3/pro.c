@@ -1,3 +1,4 @@
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -277,26 +278,35 @@ void key_val_free_function(void *data) {
 
 /*
  * Functie apelata dupa alocarea unui hashtable pentru a-l initializa.
- * Trebuie alocate si initializate si listele inlantuite.
+ * Listele inlantuite NU se aloca aici: un bucket NULL inseamna bucket gol, iar
+ * lista lui se creeaza abia la prima inserare in el (vezi ht_put). Vectorul de
+ * bucket-uri este lipit de structura, asa ca un hashtable gol costa o singura
+ * alocare, indiferent de hmax.
  */
 hashtable_t *ht_create(unsigned int hmax, unsigned int (*hash_function)(void *),
                        int (*compare_function)(void *, void *),
                        void (*key_val_free_function)(void *)) {
-  hashtable_t *hash = malloc(sizeof(*hash));
+  hashtable_t *hash = calloc(1, sizeof(*hash) + sizeof(linked_list_t *) * hmax);
   // DIE
   hash->hmax = hmax;
   hash->size = 0;
-  hash->buckets = malloc(sizeof(linked_list_t *) * hmax);
-  for (int i = 0; i < hmax; i++) {
-    hash->buckets[i] = ll_create(sizeof(info));
-    // DIE
-  }
+  hash->buckets = (linked_list_t **)(hash + 1);
   hash->compare_function = compare_function;
   hash->key_val_free_function = key_val_free_function;
   hash->hash_function = hash_function;
   return hash;
 }
 
+/*
+ * Intoarce primul nod din bucket-ul asociat cheii key sau NULL daca bucket-ul
+ * nu a fost inca alocat.
+ */
+static ll_node_t *ht_bucket_head(hashtable_t *ht, void *key) {
+  linked_list_t *bucket = ht->buckets[ht->hash_function(key) % ht->hmax];
+
+  return bucket ? bucket->head : NULL;
+}
+
 /*
  * Functie care intoarce:
  * 1, daca pentru cheia key a fost asociata anterior o valoare in hashtable
@@ -304,8 +314,7 @@ hashtable_t *ht_create(unsigned int hmax, unsigned int (*hash_function)(void *),
  * 0, altfel.
  */
 int ht_has_key(hashtable_t *ht, void *key) {
-  unsigned int index = ht->hash_function(key) % ht->hmax;
-  ll_node_t *node = ht->buckets[index]->head;
+  ll_node_t *node = ht_bucket_head(ht, key);
 
   while (node != NULL) {
     if (ht->compare_function(((info *)node->data)->key, key) == 0) return 1;
@@ -316,8 +325,7 @@ int ht_has_key(hashtable_t *ht, void *key) {
 }
 
 void *ht_get(hashtable_t *ht, void *key) {
-  unsigned int index = ht->hash_function(key) % ht->hmax;
-  ll_node_t *node = ht->buckets[index]->head;
+  ll_node_t *node = ht_bucket_head(ht, key);
 
   while (node != NULL) {
     if (ht->compare_function(((info *)node->data)->key, key) == 0)
@@ -355,6 +363,9 @@ void ht_put(hashtable_t *ht, void *key, unsigned int key_size, void *value,
     date->value = malloc(value_size);
     memcpy(date->key, key, key_size);
     memcpy(date->value, value, value_size);
+    if (ht->buckets[index] == NULL) {
+      ht->buckets[index] = ll_create(sizeof(info));
+    }
     ll_add_nth_node(ht->buckets[index], 0, date);
     free(date);
   } else {
@@ -378,14 +389,19 @@ void ht_put(hashtable_t *ht, void *key, unsigned int key_size, void *value,
 void ht_remove_entry(hashtable_t *ht, void *key) {
   unsigned int index = ht->hash_function(key) % ht->hmax;
   linked_list_t *bucket = ht->buckets[index];
-  ll_node_t *node = bucket->head;
+  ll_node_t *node;
   unsigned int poz = 0;
+
+  if (bucket == NULL) return;
+
+  node = bucket->head;
   while (node != NULL) {
     if (ht->compare_function(((info *)node->data)->key, key) == 0) {
       ll_node_t *rm = ll_remove_nth_node(bucket, poz);
-      ht->key_val_free_function(node->data);
+      ht->key_val_free_function(rm->data);
       free(rm->data);
       free(rm);
+      ht->size--;
       return;
     }
 
@@ -394,21 +410,81 @@ void ht_remove_entry(hashtable_t *ht, void *key) {
   }
 }
 
+/*
+ * Apeleaza func(key, value, arg) pentru fiecare intrare din hashtable.
+ * func nu are voie sa adauge sau sa elimine intrari in timpul parcurgerii.
+ */
+void ht_foreach(hashtable_t *ht, void (*func)(void *, void *, void *),
+                void *arg) {
+  for (unsigned int i = 0; i < ht->hmax; i++) {
+    if (ht->buckets[i] == NULL) continue;
+
+    for (ll_node_t *node = ht->buckets[i]->head; node; node = node->next)
+      func(((info *)node->data)->key, ((info *)node->data)->value, arg);
+  }
+}
+
+/*
+ * Parcurgere reluabila: viziteaza intrarile bucket-ului indicat de cursor (si
+ * ale celor goale de dupa el, pana la primul nevid) si intoarce cursorul de la
+ * care trebuie continuat, sau 0 cand parcurgerea s-a terminat. Prima chemare
+ * se face cu cursor = 0.
+ *
+ * Cursorul este doar un index de bucket, nu un pointer in liste, deci intre
+ * doua apeluri se pot face put / remove: fiecare intrare prezenta pe toata
+ * durata parcurgerii este vizitata exact o data.
+ */
+unsigned int ht_scan(hashtable_t *ht, unsigned int cursor,
+                     void (*func)(void *, void *, void *), void *arg) {
+  for (; cursor < ht->hmax; cursor++) {
+    linked_list_t *bucket = ht->buckets[cursor];
+
+    if (bucket == NULL || bucket->head == NULL) continue;
+
+    for (ll_node_t *node = bucket->head; node; node = node->next)
+      func(((info *)node->data)->key, ((info *)node->data)->value, arg);
+
+    return cursor + 1 < ht->hmax ? cursor + 1 : 0;
+  }
+
+  return 0;
+}
+
+/*
+ * Copiaza in vectorul out (alocat de apelant, de cel putin max elemente)
+ * perechile (key, value) ale primelor max intrari din hashtable. Pointerii
+ * indica direct in memoria hashtable-ului si raman valizi pana la eliminarea
+ * intrarii. Intoarce numarul de perechi scrise.
+ */
+unsigned int ht_export(hashtable_t *ht, info *out, unsigned int max) {
+  unsigned int nr = 0;
+
+  for (unsigned int i = 0; i < ht->hmax && nr < max; i++) {
+    if (ht->buckets[i] == NULL) continue;
+
+    for (ll_node_t *node = ht->buckets[i]->head; node && nr < max;
+         node = node->next)
+      out[nr++] = *(info *)node->data;
+  }
+
+  return nr;
+}
+
+static void ht_free_entry(void *key, void *value, void *arg) {
+  (void)arg;
+  free(key);
+  free(value);
+}
+
 /*
  * Procedura care elibereaza memoria folosita de toate intrarile din hashtable,
  * dupa care elibereaza si memoria folosita pentru a stoca structura hashtable.
+ * Cheile si valorile se elibereaza prin ht_foreach; ll_free elibereaza apoi
+ * structurile info si nodurile din fiecare bucket.
  */
 void ht_free(hashtable_t *ht) {
-  for (int i = 0; i < ht->hmax; i++) {
-    ll_node_t *node = ht->buckets[i]->head;
-    while (node != NULL) {
-      free(((info *)node->data)->key);
-      free(((info *)node->data)->value);
-      node = node->next;
-    }
-    ll_free(&ht->buckets[i]);
-  }
-  free(ht->buckets);
+  ht_foreach(ht, ht_free_entry, NULL);
+  for (unsigned int i = 0; i < ht->hmax; i++) ll_free(&ht->buckets[i]);
   free(ht);
 }
 
@@ -424,78 +500,453 @@ unsigned int ht_get_hmax(hashtable_t *ht) {
   return ht->hmax;
 }
 
+/*
+ * Tabel de inregistrari de dimensiune fixa. Cheia primara este un id int
+ * sintetic, atribuit de table_put si scris in inregistrare la offset-ul
+ * id_offset, deci doua inregistrari cu aceleasi valori in toate celelalte
+ * campuri raman distincte. Optional, tabelul are mai multe indexuri secundare,
+ * neunice:
+ * - index hash pe un camp string: valoare camp -> lista inregistrarilor cu acea
+ *   valoare (cautare exacta in O(1) mediu);
+ * - index ordonat pe un camp int: vector sortat de perechi (valoare,
+ *   inregistrare), cautare pe interval in O(log n + k). Inserarea si
+ *   stergerea muta elementele de dupa pozitie (memmove), deci costa O(n).
+ * Indexurile se declara o singura data, prin offset-ul campului in
+ * inregistrare, si sunt actualizate automat de table_put si table_remove.
+ */
+#define MAX_INDEXES 4
+
+typedef struct hash_index_t hash_index_t;
+struct hash_index_t {
+  /* Offset-ul campului string indexat. */
+  unsigned int field_offset;
+  /* Valoare camp -> (linked_list_t *) cu pointeri la inregistrari. */
+  hashtable_t *groups;
+};
+
+typedef struct int_entry_t int_entry_t;
+struct int_entry_t {
+  int key;
+  void *record;
+};
+
+typedef struct ordered_index_t ordered_index_t;
+struct ordered_index_t {
+  /* Offset-ul campului int indexat. */
+  unsigned int field_offset;
+  /* Intrari sortate crescator dupa key. */
+  int_entry_t *entries;
+  unsigned int size;
+  unsigned int capacity;
+};
+
+typedef struct table_t table_t;
+struct table_t {
+  /* Id -> inregistrare (detinatorul memoriei inregistrarilor). */
+  hashtable_t *rows;
+  unsigned int record_size;
+  /* Offset-ul campului int in care se scrie id-ul inregistrarii. */
+  unsigned int id_offset;
+  /* Id-ul urmatoarei inregistrari inserate. */
+  int next_id;
+  hash_index_t hash_idx[MAX_INDEXES];
+  unsigned int nr_hash_idx;
+  ordered_index_t ord_idx[MAX_INDEXES];
+  unsigned int nr_ord_idx;
+};
+
+#define FIELD_STR(record, offset) ((char *)(record) + (offset))
+#define FIELD_INT(record, offset) (*(int *)((char *)(record) + (offset)))
+
+table_t *table_create(unsigned int hmax, unsigned int record_size,
+                      unsigned int id_offset) {
+  table_t *t = calloc(1, sizeof(*t));
+
+  t->rows = ht_create(hmax, hash_function_int, compare_function_ints,
+                      key_val_free_function);
+  t->record_size = record_size;
+  t->id_offset = id_offset;
+
+  return t;
+}
+
+/*
+ * Declara un index hash pe campul string de la offset-ul field_offset.
+ * Indexurile trebuie declarate inainte de prima inserare in tabel. Intoarce
+ * identificatorul indexului, folosit la interogari, sau -1 daca nu mai este
+ * loc.
+ */
+int table_add_hash_index(table_t *t, unsigned int field_offset) {
+  hash_index_t *idx;
+
+  if (t->nr_hash_idx == MAX_INDEXES) return -1;
+
+  idx = &t->hash_idx[t->nr_hash_idx];
+  idx->field_offset = field_offset;
+  idx->groups = ht_create(ht_get_hmax(t->rows), hash_function_string,
+                          compare_function_strings, key_val_free_function);
+
+  return t->nr_hash_idx++;
+}
+
+/*
+ * Declara un index ordonat pe campul int de la offset-ul field_offset.
+ * Aceleasi reguli ca la table_add_hash_index.
+ */
+int table_add_ordered_index(table_t *t, unsigned int field_offset) {
+  ordered_index_t *idx;
+
+  if (t->nr_ord_idx == MAX_INDEXES) return -1;
+
+  idx = &t->ord_idx[t->nr_ord_idx];
+  idx->field_offset = field_offset;
+  idx->entries = NULL;
+  idx->size = 0;
+  idx->capacity = 0;
+
+  return t->nr_ord_idx++;
+}
+
+static void hash_index_add(hash_index_t *idx, void *record) {
+  char *value = FIELD_STR(record, idx->field_offset);
+  linked_list_t **group = ht_get(idx->groups, value);
+
+  if (group == NULL) {
+    linked_list_t *new_group = ll_create(sizeof(void *));
+
+    ht_put(idx->groups, value, strlen(value) + 1, &new_group,
+           sizeof(new_group));
+    group = ht_get(idx->groups, value);
+  }
+
+  ll_add_nth_node(*group, (*group)->size, &record);
+}
+
+static void hash_index_remove(hash_index_t *idx, void *record) {
+  char *value = FIELD_STR(record, idx->field_offset);
+  linked_list_t **group = ht_get(idx->groups, value);
+  ll_node_t *node, *rm;
+  unsigned int poz = 0;
+
+  if (group == NULL) return;
+
+  for (node = (*group)->head; node != NULL; node = node->next, poz++) {
+    if (*(void **)node->data == record) {
+      rm = ll_remove_nth_node(*group, poz);
+      free(rm->data);
+      free(rm);
+      break;
+    }
+  }
+
+  if ((*group)->size == 0) {
+    ll_free(group);
+    ht_remove_entry(idx->groups, value);
+  }
+}
+
+/*
+ * Intoarce pozitia primei intrari cu cheia >= key (upper = 0), respectiv
+ * > key (upper = 1), prin cautare binara.
+ */
+static unsigned int ordered_index_bound(ordered_index_t *idx, int key,
+                                        int upper) {
+  unsigned int lo = 0, hi = idx->size;
+
+  while (lo < hi) {
+    unsigned int mid = lo + (hi - lo) / 2;
+
+    if (idx->entries[mid].key < key || (upper && idx->entries[mid].key == key))
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+/*
+ * Cautarea pozitiei este O(log n), dar mutarea intrarilor de dupa ea este
+ * O(n), deci n inserari costa O(n^2) in cel mai rau caz. Cand valorile vin in
+ * ordine crescatoare (de ex. la incarcarea unor date sortate), pozitia este
+ * mereu la final si inserarea este O(1) amortizat.
+ */
+static void ordered_index_add(ordered_index_t *idx, void *record) {
+  int key = FIELD_INT(record, idx->field_offset);
+  /* Inseram dupa toate intrarile egale, ca sa pastram ordinea inserarii. */
+  unsigned int poz = ordered_index_bound(idx, key, 1);
+
+  if (idx->size == idx->capacity) {
+    idx->capacity = idx->capacity ? 2 * idx->capacity : 16;
+    idx->entries = realloc(idx->entries, idx->capacity * sizeof(int_entry_t));
+  }
+
+  memmove(&idx->entries[poz + 1], &idx->entries[poz],
+          (idx->size - poz) * sizeof(int_entry_t));
+  idx->entries[poz].key = key;
+  idx->entries[poz].record = record;
+  idx->size++;
+}
+
+static void ordered_index_remove(ordered_index_t *idx, void *record) {
+  int key = FIELD_INT(record, idx->field_offset);
+  unsigned int poz = ordered_index_bound(idx, key, 0);
+
+  for (; poz < idx->size && idx->entries[poz].key == key; poz++) {
+    if (idx->entries[poz].record == record) {
+      memmove(&idx->entries[poz], &idx->entries[poz + 1],
+              (idx->size - poz - 1) * sizeof(int_entry_t));
+      idx->size--;
+      return;
+    }
+  }
+}
+
+static void table_index_record(table_t *t, void *record) {
+  for (unsigned int i = 0; i < t->nr_hash_idx; i++)
+    hash_index_add(&t->hash_idx[i], record);
+  for (unsigned int i = 0; i < t->nr_ord_idx; i++)
+    ordered_index_add(&t->ord_idx[i], record);
+}
+
+static void table_unindex_record(table_t *t, void *record) {
+  for (unsigned int i = 0; i < t->nr_hash_idx; i++)
+    hash_index_remove(&t->hash_idx[i], record);
+  for (unsigned int i = 0; i < t->nr_ord_idx; i++)
+    ordered_index_remove(&t->ord_idx[i], record);
+}
+
+void *table_get(table_t *t, int id) { return ht_get(t->rows, &id); }
+
+/*
+ * Insereaza o copie a inregistrarii record, cu un id nou (scris si in
+ * record), si o adauga in toate indexurile. Intoarce id-ul.
+ */
+int table_put(table_t *t, void *record) {
+  int id = t->next_id++;
+  void *stored;
+
+  FIELD_INT(record, t->id_offset) = id;
+  ht_put(t->rows, &id, sizeof(id), record, t->record_size);
+  stored = ht_get(t->rows, &id);
+  table_index_record(t, stored);
+
+  return id;
+}
+
+void table_remove(table_t *t, int id) {
+  void *stored = ht_get(t->rows, &id);
+
+  if (stored == NULL) return;
+
+  table_unindex_record(t, stored);
+  ht_remove_entry(t->rows, &id);
+}
+
+/*
+ * Intoarce lista (de void *) a inregistrarilor al caror camp indexat de
+ * indexul hash idx_id are valoarea value, sau NULL daca nu exista niciuna.
+ * Lista apartine indexului si nu trebuie modificata de apelant.
+ */
+linked_list_t *table_find(table_t *t, int idx_id, char *value) {
+  linked_list_t **group = ht_get(t->hash_idx[idx_id].groups, value);
+
+  return group ? *group : NULL;
+}
+
+/*
+ * Apeleaza func pentru fiecare inregistrare al carei camp indexat de indexul
+ * ordonat idx_id se afla in intervalul [lo, hi], in ordine crescatoare.
+ * Intoarce numarul de inregistrari gasite.
+ */
+unsigned int table_range(table_t *t, int idx_id, int lo, int hi,
+                         void (*func)(void *)) {
+  ordered_index_t *idx = &t->ord_idx[idx_id];
+  unsigned int poz = ordered_index_bound(idx, lo, 0);
+  unsigned int nr = 0;
+
+  for (; poz < idx->size && idx->entries[poz].key <= hi; poz++, nr++)
+    func(idx->entries[poz].record);
+
+  return nr;
+}
+
+/*
+ * Un pas de parcurgere reluabila (ht_scan) a grupurilor indexului hash idx_id:
+ * func primeste valoarea campului si lista (linked_list_t *) inregistrarilor
+ * cu acea valoare. Intre doi pasi tabelul poate fi modificat.
+ */
+unsigned int table_scan_index(table_t *t, int idx_id, unsigned int cursor,
+                              void (*func)(void *, void *, void *),
+                              void *arg) {
+  return ht_scan(t->hash_idx[idx_id].groups, cursor, func, arg);
+}
+
+static int compare_info_ids(const void *a, const void *b) {
+  int id_a = *(int *)((const info *)a)->key;
+  int id_b = *(int *)((const info *)b)->key;
+
+  return (id_a > id_b) - (id_a < id_b);
+}
+
+/*
+ * Apeleaza func pentru fiecare inregistrare, in ordinea id-urilor, adica a
+ * inserarii. Inregistrarile se copiaza cu ht_export intr-un singur vector
+ * (fara alocari per intrare), care apoi se sorteaza. Intoarce numarul lor.
+ */
+unsigned int table_report(table_t *t, void (*func)(void *)) {
+  unsigned int nr = ht_get_size(t->rows);
+  info *entries = malloc((nr + 1) * sizeof(info));
+
+  nr = ht_export(t->rows, entries, nr);
+  qsort(entries, nr, sizeof(info), compare_info_ids);
+  for (unsigned int i = 0; i < nr; i++) func(entries[i].value);
+  free(entries);
+
+  return nr;
+}
+
+static void free_group(void *key, void *value, void *arg) {
+  (void)key;
+  (void)arg;
+  ll_free((linked_list_t **)value);
+}
+
+void table_free(table_t *t) {
+  for (unsigned int i = 0; i < t->nr_hash_idx; i++) {
+    ht_foreach(t->hash_idx[i].groups, free_group, NULL);
+    ht_free(t->hash_idx[i].groups);
+  }
+  for (unsigned int i = 0; i < t->nr_ord_idx; i++) free(t->ord_idx[i].entries);
+
+  ht_free(t->rows);
+  free(t);
+}
+
 struct PatientInfo {
+  int id;
   char name[MAX_STRING_SIZE];
   char city[MAX_STRING_SIZE];
   char health[MAX_STRING_SIZE];
   int age;
 };
 
-static void print_patient(struct PatientInfo *p_info) {
+static void print_city(void *key, void *value, void *arg) {
+  (void)arg;
+  printf("%s: %u\n", (char *)key, (*(linked_list_t **)value)->size);
+}
+
+static void print_patient(void *data) {
+  struct PatientInfo *p_info = data;
+
   printf("Nume: %s;", p_info->name);
   printf(" Oras: %s;", p_info->city);
   printf(" Varsta: %d;", p_info->age);
   printf(" Stare de sanatate: %s\n", p_info->health);
 }
-int count(hashtable_t *ht, void *key) {
-  unsigned int index = ht->hash_function(key) % ht->hmax;
-  ll_node_t *node = ht->buckets[index]->head;
-  int count = 0;
-  while (node != NULL) {
-    count++;
-    node = node->next;
-  }
-  return count;
-}
 
 int main() {
-  hashtable_t *ht_patients = NULL;
+  table_t *patients = NULL;
   struct PatientInfo info_f;
-  struct PatientInfo *info = NULL;
+  int by_name = -1, by_city = -1, by_age = -1;
 
   while (1) {
     char command[MAX_STRING_SIZE];
 
     scanf("%s", command);
     if (strncmp(command, "create_ht", 9) == 0) {
-      ht_patients = ht_create(HMAX, hash_function_string,
-                              compare_function_strings, key_val_free_function);
-      /* E de ajuns un singur hashtable? */
+      /*
+       * Cheia primara este id-ul dat de table_put, fiindca doi pacienti pot
+       * avea acelasi nume; numele, orasul si varsta sunt indexuri secundare.
+       */
+      patients = table_create(HMAX, sizeof(struct PatientInfo),
+                              offsetof(struct PatientInfo, id));
+      by_name = table_add_hash_index(patients,
+                                     offsetof(struct PatientInfo, name));
+      by_city = table_add_hash_index(patients,
+                                     offsetof(struct PatientInfo, city));
+      by_age = table_add_ordered_index(patients,
+                                       offsetof(struct PatientInfo, age));
 
     } else if (strncmp(command, "add_patients", 12) == 0) {
       int nr;
       scanf("%d", &nr);
       for (int i = 0; i < nr; i++) {
+        memset(&info_f, 0, sizeof(info_f));
         scanf("%s %s %d %s", info_f.name, info_f.city, &info_f.age,
               info_f.health);
-        ht_put(ht_patients, info_f.city, strlen(info_f.city) + 1, &info_f,
-               sizeof(info_f));
+        table_put(patients, &info_f);
       }
 
     } else if (strncmp(command, "print_patients_from", 19) == 0) {
       char oras[MAX_STRING_SIZE];
+      linked_list_t *group;
+
       scanf("%s", oras);
-      info = ht_get(ht_patients, oras);
-      if (info == NULL) {
-        printf("Patients from %s not found", oras);
+      group = table_find(patients, by_city, oras);
+      if (group == NULL) {
+        printf("Patients from %s not found\n", oras);
+      } else {
+        for (ll_node_t *node = group->head; node; node = node->next)
+          print_patient(*(void **)node->data);
       }
-      int nr = count(ht_patients, oras);
-      for (int i = 0; i < nr; i++) {
-        print_patient(info);
-        ht_put(ht_patients, info->city, strlen(info->city) + 1, &info,
-               sizeof(info));
-        ht_remove_entry(ht_patients, oras);
+
+    } else if (strncmp(command, "report_patients", 15) == 0) {
+      if (table_report(patients, print_patient) == 0)
+        printf("No patients\n");
+
+    } else if (strncmp(command, "print_cities", 12) == 0) {
+      unsigned int cursor = 0;
+
+      /* Orasele si numarul de pacienti, cate un bucket al indexului. */
+      do {
+        cursor = table_scan_index(patients, by_city, cursor, print_city, NULL);
+      } while (cursor != 0);
+
+    } else if (strncmp(command, "print_patients_aged", 19) == 0) {
+      int lo, hi;
+
+      scanf("%d %d", &lo, &hi);
+      if (table_range(patients, by_age, lo, hi, print_patient) == 0)
+        printf("Patients aged %d-%d not found\n", lo, hi);
+
+    } else if (strncmp(command, "print_patient", 13) == 0) {
+      char name[MAX_STRING_SIZE];
+      linked_list_t *group;
+
+      scanf("%s", name);
+      group = table_find(patients, by_name, name);
+      if (group == NULL) {
+        printf("Patient %s not found\n", name);
+      } else {
+        for (ll_node_t *node = group->head; node; node = node->next)
+          print_patient(*(void **)node->data);
+      }
+
+    } else if (strncmp(command, "remove_patient", 14) == 0) {
+      char name[MAX_STRING_SIZE];
+      linked_list_t *group;
+
+      /*
+       * Sterge toti pacientii cu numele dat. Grupul este eliberat odata cu
+       * ultimul pacient, deci se cere din nou dupa fiecare stergere.
+       */
+      scanf("%s", name);
+      while ((group = table_find(patients, by_name, name)) != NULL) {
+        struct PatientInfo *p = *(void **)group->head->data;
+
+        table_remove(patients, p->id);
       }
 
     } else if (strncmp(command, "free", 4) == 0) {
-      if (!ht_patients) {
+      if (!patients) {
         printf("Create hashtable first.\n");
       } else {
-        ht_free(ht_patients);
+        table_free(patients);
       }
       break;
     }
   }
 
   return 0;
-}
\ No newline at end of file
+}
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #define MAX_STRING_SIZE 256
 #define HMAX 10
@@ -278,26 +279,35 @@ void key_val_free_function(void *data) {
 
 /*
  * Functie apelata dupa alocarea unui hashtable pentru a-l initializa.
- * Trebuie alocate si initializate si listele inlantuite.
+ * Listele inlantuite NU se aloca aici: un bucket NULL inseamna bucket gol, iar
+ * lista lui se creeaza abia la prima inserare in el (vezi ht_put). Vectorul de
+ * bucket-uri este lipit de structura, asa ca un hashtable gol costa o singura
+ * alocare, indiferent de hmax.
  */
 hashtable_t *ht_create(unsigned int hmax, unsigned int (*hash_function)(void *),
                        int (*compare_function)(void *, void *),
                        void (*key_val_free_function)(void *)) {
-  hashtable_t *hash = malloc(sizeof(*hash));
+  hashtable_t *hash = calloc(1, sizeof(*hash) + sizeof(linked_list_t *) * hmax);
   // DIE
   hash->hmax = hmax;
   hash->size = 0;
-  hash->buckets = malloc(sizeof(linked_list_t *) * hmax);
-  for (int i = 0; i < hmax; i++) {
-    hash->buckets[i] = ll_create(sizeof(info));
-    // DIE
-  }
+  hash->buckets = (linked_list_t **)(hash + 1);
   hash->compare_function = compare_function;
   hash->key_val_free_function = key_val_free_function;
   hash->hash_function = hash_function;
   return hash;
 }
 
+/*
+ * Intoarce primul nod din bucket-ul asociat cheii key sau NULL daca bucket-ul
+ * nu a fost inca alocat.
+ */
+static ll_node_t *ht_bucket_head(hashtable_t *ht, void *key) {
+  linked_list_t *bucket = ht->buckets[ht->hash_function(key) % ht->hmax];
+
+  return bucket ? bucket->head : NULL;
+}
+
 /*
  * Functie care intoarce:
  * 1, daca pentru cheia key a fost asociata anterior o valoare in hashtable
@@ -305,8 +315,7 @@ hashtable_t *ht_create(unsigned int hmax, unsigned int (*hash_function)(void *),
  * 0, altfel.
  */
 int ht_has_key(hashtable_t *ht, void *key) {
-  unsigned int index = ht->hash_function(key) % ht->hmax;
-  ll_node_t *node = ht->buckets[index]->head;
+  ll_node_t *node = ht_bucket_head(ht, key);
 
   while (node != NULL) {
     if (ht->compare_function(((info *)node->data)->key, key) == 0) return 1;
@@ -317,8 +326,7 @@ int ht_has_key(hashtable_t *ht, void *key) {
 }
 
 void *ht_get(hashtable_t *ht, void *key) {
-  unsigned int index = ht->hash_function(key) % ht->hmax;
-  ll_node_t *node = ht->buckets[index]->head;
+  ll_node_t *node = ht_bucket_head(ht, key);
 
   while (node != NULL) {
     if (ht->compare_function(((info *)node->data)->key, key) == 0)
@@ -356,6 +364,9 @@ void ht_put(hashtable_t *ht, void *key, unsigned int key_size, void *value,
     date->value = malloc(value_size);
     memcpy(date->key, key, key_size);
     memcpy(date->value, value, value_size);
+    if (ht->buckets[index] == NULL) {
+      ht->buckets[index] = ll_create(sizeof(info));
+    }
     ll_add_nth_node(ht->buckets[index], 0, date);
     free(date);
   } else {
@@ -379,14 +390,19 @@ void ht_put(hashtable_t *ht, void *key, unsigned int key_size, void *value,
 void ht_remove_entry(hashtable_t *ht, void *key) {
   unsigned int index = ht->hash_function(key) % ht->hmax;
   linked_list_t *bucket = ht->buckets[index];
-  ll_node_t *node = bucket->head;
+  ll_node_t *node;
   unsigned int poz = 0;
+
+  if (bucket == NULL) return;
+
+  node = bucket->head;
   while (node != NULL) {
     if (ht->compare_function(((info *)node->data)->key, key) == 0) {
       ll_node_t *rm = ll_remove_nth_node(bucket, poz);
-      ht->key_val_free_function(node->data);
-      free(rm->data);
+      /* Elibereaza cheia, valoarea si structura info (rm->data). */
+      ht->key_val_free_function(rm->data);
       free(rm);
+      ht->size--;
       return;
     }
 
@@ -395,21 +411,81 @@ void ht_remove_entry(hashtable_t *ht, void *key) {
   }
 }
 
+/*
+ * Apeleaza func(key, value, arg) pentru fiecare intrare din hashtable.
+ * func nu are voie sa adauge sau sa elimine intrari in timpul parcurgerii.
+ */
+void ht_foreach(hashtable_t *ht, void (*func)(void *, void *, void *),
+                void *arg) {
+  for (unsigned int i = 0; i < ht->hmax; i++) {
+    if (ht->buckets[i] == NULL) continue;
+
+    for (ll_node_t *node = ht->buckets[i]->head; node; node = node->next)
+      func(((info *)node->data)->key, ((info *)node->data)->value, arg);
+  }
+}
+
+/*
+ * Parcurgere reluabila: viziteaza intrarile bucket-ului indicat de cursor (si
+ * ale celor goale de dupa el, pana la primul nevid) si intoarce cursorul de la
+ * care trebuie continuat, sau 0 cand parcurgerea s-a terminat. Prima chemare
+ * se face cu cursor = 0.
+ *
+ * Cursorul este doar un index de bucket, nu un pointer in liste, deci intre
+ * doua apeluri se pot face put / remove: fiecare intrare prezenta pe toata
+ * durata parcurgerii este vizitata exact o data.
+ */
+unsigned int ht_scan(hashtable_t *ht, unsigned int cursor,
+                     void (*func)(void *, void *, void *), void *arg) {
+  for (; cursor < ht->hmax; cursor++) {
+    linked_list_t *bucket = ht->buckets[cursor];
+
+    if (bucket == NULL || bucket->head == NULL) continue;
+
+    for (ll_node_t *node = bucket->head; node; node = node->next)
+      func(((info *)node->data)->key, ((info *)node->data)->value, arg);
+
+    return cursor + 1 < ht->hmax ? cursor + 1 : 0;
+  }
+
+  return 0;
+}
+
+/*
+ * Copiaza in vectorul out (alocat de apelant, de cel putin max elemente)
+ * perechile (key, value) ale primelor max intrari din hashtable. Pointerii
+ * indica direct in memoria hashtable-ului si raman valizi pana la eliminarea
+ * intrarii. Intoarce numarul de perechi scrise.
+ */
+unsigned int ht_export(hashtable_t *ht, info *out, unsigned int max) {
+  unsigned int nr = 0;
+
+  for (unsigned int i = 0; i < ht->hmax && nr < max; i++) {
+    if (ht->buckets[i] == NULL) continue;
+
+    for (ll_node_t *node = ht->buckets[i]->head; node && nr < max;
+         node = node->next)
+      out[nr++] = *(info *)node->data;
+  }
+
+  return nr;
+}
+
+static void ht_free_entry(void *key, void *value, void *arg) {
+  (void)arg;
+  free(key);
+  free(value);
+}
+
 /*
  * Procedura care elibereaza memoria folosita de toate intrarile din hashtable,
  * dupa care elibereaza si memoria folosita pentru a stoca structura hashtable.
+ * Cheile si valorile se elibereaza prin ht_foreach; ll_free elibereaza apoi
+ * structurile info si nodurile din fiecare bucket.
  */
 void ht_free(hashtable_t *ht) {
-  for (int i = 0; i < ht->hmax; i++) {
-    ll_node_t *node = ht->buckets[i]->head;
-    while (node != NULL) {
-      free(((info *)node->data)->key);
-      free(((info *)node->data)->value);
-      node = node->next;
-    }
-    ll_free(&ht->buckets[i]);
-  }
-  free(ht->buckets);
+  ht_foreach(ht, ht_free_entry, NULL);
+  for (unsigned int i = 0; i < ht->hmax; i++) ll_free(&ht->buckets[i]);
   free(ht);
 }
 
@@ -425,6 +501,150 @@ unsigned int ht_get_hmax(hashtable_t *ht) {
   return ht->hmax;
 }
 
+/*
+ * Specializare a hashtable-ului pentru chei scalare de dimensiune fixa (int,
+ * unsigned, long, pointeri etc.), generata prin macro.
+ *
+ * Spre deosebire de hashtable_t, cheile si valorile sunt stocate direct in
+ * vectorul de intrari (adresare deschisa cu sondare liniara), functia de hash
+ * si comparatia sunt expandate inline (fara apeluri prin pointeri la functii),
+ * iar inserarea nu aloca memorie pentru fiecare cheie. Capacitatea este mereu
+ * o putere a lui 2, deci indexul se obtine prin masca in loc de %.
+ *
+ * DEFINE_SCALAR_HT(K, V, name, hash) genereaza tipul name##_t si functiile
+ * name##_create, name##_has_key, name##_get, name##_put, name##_remove_entry,
+ * name##_get_size si name##_free, cu aceeasi semantica precum ht_*.
+ * hash trebuie sa fie o expresie apelabila hash(K) -> unsigned int.
+ */
+static inline unsigned int hash_uint(unsigned int uint_a) {
+  uint_a = ((uint_a >> 16u) ^ uint_a) * 0x45d9f3b;
+  uint_a = ((uint_a >> 16u) ^ uint_a) * 0x45d9f3b;
+  uint_a = (uint_a >> 16u) ^ uint_a;
+  return uint_a;
+}
+
+#define DEFINE_SCALAR_HT(K, V, name, hash)                                    \
+  typedef struct name##_entry_t {                                             \
+    K key;                                                                    \
+    V value;                                                                  \
+  } name##_entry_t;                                                           \
+                                                                              \
+  typedef struct name##_t {                                                   \
+    name##_entry_t *entries;                                                  \
+    /* used[i] == 1 daca entries[i] contine o pereche valida. */              \
+    unsigned char *used;                                                      \
+    unsigned int size;                                                        \
+    /* Numarul de intrari; putere a lui 2. */                                 \
+    unsigned int capacity;                                                    \
+  } name##_t;                                                                 \
+                                                                              \
+  static inline void name##_alloc(name##_t *ht, unsigned int capacity) {      \
+    ht->entries = malloc(capacity * sizeof(name##_entry_t));                  \
+    ht->used = calloc(capacity, 1);                                           \
+    ht->capacity = capacity;                                                  \
+    ht->size = 0;                                                             \
+  }                                                                           \
+                                                                              \
+  static inline name##_t *name##_create(unsigned int hmax) {                  \
+    name##_t *ht = malloc(sizeof(*ht));                                       \
+    unsigned int capacity = 16;                                               \
+                                                                              \
+    while (capacity < hmax) capacity <<= 1;                                   \
+    name##_alloc(ht, capacity);                                               \
+    return ht;                                                                \
+  }                                                                           \
+                                                                              \
+  /* Pozitia cheii key sau a primului slot liber din secventa ei. */         \
+  static inline unsigned int name##_slot(name##_t *ht, K key) {               \
+    unsigned int mask = ht->capacity - 1;                                     \
+    unsigned int i = (unsigned int)hash(key) & mask;                          \
+                                                                              \
+    while (ht->used[i] && ht->entries[i].key != key) i = (i + 1) & mask;      \
+    return i;                                                                 \
+  }                                                                           \
+                                                                              \
+  static inline int name##_has_key(name##_t *ht, K key) {                     \
+    return ht->used[name##_slot(ht, key)];                                    \
+  }                                                                           \
+                                                                              \
+  static inline V *name##_get(name##_t *ht, K key) {                          \
+    unsigned int i = name##_slot(ht, key);                                    \
+                                                                              \
+    return ht->used[i] ? &ht->entries[i].value : NULL;                        \
+  }                                                                           \
+                                                                              \
+  static inline void name##_put(name##_t *ht, K key, V value);                \
+                                                                              \
+  /* Dubleaza capacitatea si reinsereaza toate perechile. */                  \
+  static inline void name##_grow(name##_t *ht) {                              \
+    name##_entry_t *old_entries = ht->entries;                                \
+    unsigned char *old_used = ht->used;                                       \
+    unsigned int old_capacity = ht->capacity;                                 \
+                                                                              \
+    name##_alloc(ht, old_capacity << 1);                                      \
+    for (unsigned int i = 0; i < old_capacity; i++)                           \
+      if (old_used[i])                                                        \
+        name##_put(ht, old_entries[i].key, old_entries[i].value);             \
+    free(old_entries);                                                        \
+    free(old_used);                                                           \
+  }                                                                           \
+                                                                              \
+  static inline void name##_put(name##_t *ht, K key, V value) {               \
+    unsigned int i;                                                           \
+                                                                              \
+    /* Factor de incarcare maxim 3/4. */                                      \
+    if (4 * (ht->size + 1) > 3 * ht->capacity) name##_grow(ht);               \
+                                                                              \
+    i = name##_slot(ht, key);                                                 \
+    if (!ht->used[i]) {                                                       \
+      ht->used[i] = 1;                                                        \
+      ht->entries[i].key = key;                                               \
+      ht->size++;                                                             \
+    }                                                                         \
+    ht->entries[i].value = value;                                             \
+  }                                                                           \
+                                                                              \
+  /*                                                                          \
+   * Stergere fara marcaje: intrarile urmatoare din aceeasi secventa sunt     \
+   * mutate inapoi, ca sa nu ramana "gauri" care ar opri sondarea.            \
+   */                                                                         \
+  static inline void name##_remove_entry(name##_t *ht, K key) {               \
+    unsigned int mask = ht->capacity - 1;                                     \
+    unsigned int i = name##_slot(ht, key), j = i, home;                       \
+                                                                              \
+    if (!ht->used[i]) return;                                                 \
+                                                                              \
+    while (1) {                                                               \
+      j = (j + 1) & mask;                                                     \
+      if (!ht->used[j]) break;                                                \
+      home = (unsigned int)hash(ht->entries[j].key) & mask;                   \
+      /* entries[j] poate ocupa slotul i doar daca home nu e in (i, j]. */    \
+      if ((j > i && (home <= i || home > j)) ||                               \
+          (j < i && (home <= i && home > j))) {                               \
+        ht->entries[i] = ht->entries[j];                                      \
+        i = j;                                                                \
+      }                                                                       \
+    }                                                                         \
+    ht->used[i] = 0;                                                          \
+    ht->size--;                                                               \
+  }                                                                           \
+                                                                              \
+  static inline unsigned int name##_get_size(name##_t *ht) {                  \
+    return ht ? ht->size : 0;                                                 \
+  }                                                                           \
+                                                                              \
+  static inline void name##_free(name##_t *ht) {                              \
+    free(ht->entries);                                                        \
+    free(ht->used);                                                           \
+    free(ht);                                                                 \
+  }
+
+/*
+ * Hashtable int -> int, fara indirectari si fara alocari per cheie. Se compara
+ * cu hashtable_t in --bench.
+ */
+DEFINE_SCALAR_HT(int, int, int_ht, hash_uint)
+
 struct FriendInfo {
   char name[MAX_STRING_SIZE];
   char faculty[MAX_STRING_SIZE];
@@ -443,11 +663,162 @@ static void print_friend(struct FriendInfo *f_info) {
   printf("Favorite food: %s\n", f_info->fav_food);
 }
 
-int main() {
+static void print_friend_entry(void *key, void *value, void *arg) {
+  (void)key;
+  (void)arg;
+  print_friend(value);
+}
+
+static int compare_info_names(const void *a, const void *b) {
+  return strcmp(((const info *)a)->key, ((const info *)b)->key);
+}
+
+/*
+ * Afiseaza toti prietenii in ordinea alfabetica a numelor. Tabelul este copiat
+ * cu ht_export intr-un singur vector (fara alocari per intrare), care apoi se
+ * sorteaza.
+ */
+static void report_friends(hashtable_t *ht) {
+  unsigned int nr = ht_get_size(ht);
+  info *entries = malloc((nr + 1) * sizeof(info));
+
+  nr = ht_export(ht, entries, nr);
+  qsort(entries, nr, sizeof(info), compare_info_names);
+  for (unsigned int i = 0; i < nr; i++) print_friend(entries[i].value);
+  free(entries);
+}
+
+typedef struct {
+  int age;
+  /* Numele gasite in pasul curent al parcurgerii. */
+  linked_list_t *names;
+} older_ctx_t;
+
+static void collect_older(void *key, void *value, void *arg) {
+  older_ctx_t *ctx = arg;
+  char name[MAX_STRING_SIZE];
+
+  if (((struct FriendInfo *)value)->age > ctx->age) {
+    snprintf(name, sizeof(name), "%s", (char *)key);
+    ll_add_nth_node(ctx->names, 0, name);
+  }
+}
+
+/*
+ * Sterge prietenii mai in varsta de age si intoarce cati au fost stersi.
+ * ht_foreach nu permite stergeri in timpul parcurgerii, asa ca tabelul se
+ * parcurge cu ht_scan, cate un bucket, iar numele gasite se sterg intre doi
+ * pasi ai cursorului.
+ */
+static int remove_older_friends(hashtable_t *ht, int age) {
+  older_ctx_t ctx = {age, ll_create(MAX_STRING_SIZE)};
+  unsigned int cursor = 0;
+  int removed = 0;
+
+  do {
+    cursor = ht_scan(ht, cursor, collect_older, &ctx);
+    while (ll_get_size(ctx.names) > 0) {
+      ll_node_t *node = ll_remove_nth_node(ctx.names, 0);
+
+      ht_remove_entry(ht, node->data);
+      free(node->data);
+      free(node);
+      removed++;
+    }
+  } while (cursor != 0);
+
+  ll_free(&ctx.names);
+  return removed;
+}
+
+static double elapsed(clock_t begin) {
+  return (double)(clock() - begin) / CLOCKS_PER_SEC;
+}
+
+/*
+ * Compara hashtable_t (chei int prin void *, hash_function_int) cu int_ht pe
+ * aceleasi n chei aleatoare: put pentru toate, get pentru toate, remove pentru
+ * cele de pe pozitii pare si has_key pentru toate. Cele doua tabele trebuie sa
+ * dea aceleasi rezultate. hashtable_t nu se redimensioneaza, asa ca primeste
+ * direct n bucket-uri. Se ruleaza cu ./tema1 --bench [n].
+ */
+static void bench(int n) {
+  const char *phases[] = {"put", "get", "remove", "has_key"};
+  int *keys = malloc(n * sizeof(int));
+  hashtable_t *ht =
+      ht_create(n, hash_function_int, compare_function_ints,
+                key_val_free_function);
+  int_ht_t *iht = int_ht_create(n);
+  long long sum[2] = {0, 0};
+  int found[2] = {0, 0};
+  double secs[2][4];
+  clock_t begin;
+
+  srand(42);
+  for (int i = 0; i < n; i++) keys[i] = rand();
+
+  begin = clock();
+  for (int i = 0; i < n; i++)
+    ht_put(ht, &keys[i], sizeof(int), &i, sizeof(int));
+  secs[0][0] = elapsed(begin);
+  begin = clock();
+  for (int i = 0; i < n; i++) {
+    int *value = ht_get(ht, &keys[i]);
+    if (value) sum[0] += *value;
+  }
+  secs[0][1] = elapsed(begin);
+  begin = clock();
+  for (int i = 0; i < n; i += 2) ht_remove_entry(ht, &keys[i]);
+  secs[0][2] = elapsed(begin);
+  begin = clock();
+  for (int i = 0; i < n; i++) found[0] += ht_has_key(ht, &keys[i]);
+  secs[0][3] = elapsed(begin);
+
+  begin = clock();
+  for (int i = 0; i < n; i++) int_ht_put(iht, keys[i], i);
+  secs[1][0] = elapsed(begin);
+  begin = clock();
+  for (int i = 0; i < n; i++) {
+    int *value = int_ht_get(iht, keys[i]);
+    if (value) sum[1] += *value;
+  }
+  secs[1][1] = elapsed(begin);
+  begin = clock();
+  for (int i = 0; i < n; i += 2) int_ht_remove_entry(iht, keys[i]);
+  secs[1][2] = elapsed(begin);
+  begin = clock();
+  for (int i = 0; i < n; i++) found[1] += int_ht_has_key(iht, keys[i]);
+  secs[1][3] = elapsed(begin);
+
+  printf("n = %d\n", n);
+  printf("%-8s %16s %16s\n", "", "hashtable_t", "int_ht");
+  for (int p = 0; p < 4; p++) {
+    int ops = p == 2 ? (n + 1) / 2 : n;
+
+    printf("%-8s %13.1f ns %13.1f ns\n", phases[p], secs[0][p] * 1e9 / ops,
+           secs[1][p] * 1e9 / ops);
+  }
+  if (sum[0] != sum[1] || found[0] != found[1] ||
+      ht_get_size(ht) != int_ht_get_size(iht))
+    printf("MISMATCH: hashtable_t si int_ht dau rezultate diferite!\n");
+  else
+    printf("ok: %u chei ramase in ambele tabele\n", ht_get_size(ht));
+
+  ht_free(ht);
+  int_ht_free(iht);
+  free(keys);
+}
+
+int main(int argc, char *argv[]) {
   hashtable_t *ht_friends = NULL;
   struct FriendInfo info_f;
   struct FriendInfo *p_infoFriend;
 
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+    bench(argc > 2 ? atoi(argv[2]) : 1 << 20);
+    return 0;
+  }
+
   while (1) {
     char command[MAX_STRING_SIZE];
 
@@ -479,6 +850,31 @@ int main() {
         print_friend(p_infoFriend);
       }
 
+    } else if (strncmp(command, "print_all_friends", 17) == 0) {
+      if (!ht_friends) {
+        printf("Create hashtable first.\n");
+      } else {
+        ht_foreach(ht_friends, print_friend_entry, NULL);
+      }
+
+    } else if (strncmp(command, "report_friends", 14) == 0) {
+      if (!ht_friends) {
+        printf("Create hashtable first.\n");
+      } else {
+        report_friends(ht_friends);
+      }
+
+    } else if (strncmp(command, "remove_older_friends", 20) == 0) {
+      int age;
+
+      scanf("%d", &age);
+      if (!ht_friends) {
+        printf("Create hashtable first.\n");
+      } else {
+        printf("Removed %d friends older than %d.\n",
+               remove_older_friends(ht_friends, age), age);
+      }
+
     } else if (strncmp(command, "check_friend", 12) == 0) {
       char name[MAX_STRING_SIZE];
 
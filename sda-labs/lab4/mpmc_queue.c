@@ -0,0 +1,465 @@
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define DIE(assertion, call_description)                 \
+  do {                                                   \
+    if (assertion) {                                     \
+      fprintf(stderr, "(%s, %d): ", __FILE__, __LINE__); \
+      perror(call_description);                          \
+      exit(errno);                                       \
+    }                                                    \
+  } while (0)
+
+#define CACHE_LINE 64
+/* Incercari de a relua o operatie inainte de a adormi pe futex */
+#define MQ_SPIN_COUNT 64
+
+#define BENCH_ITEMS (1 << 21)
+#define BENCH_CAPACITY 1024
+#define BENCH_MAX_BATCH 64
+#define BENCH_STOP (-1L)
+
+/*
+ * Coada circulara marginita, pentru oricati producatori si consumatori
+ * (algoritmul lui Dmitry Vyukov).
+ *
+ * Fiecare slot are un numar de secventa seq. Pentru pozitia pos (care creste
+ * la nesfarsit, slotul fiind pos & mask):
+ *  - seq == pos           slotul e liber si asteapta producatorul lui pos;
+ *  - seq == pos + 1       slotul contine elementul lui pos, gata de citit;
+ *  - seq == pos + mask + 1 consumatorul l-a eliberat pentru tura urmatoare.
+ * Un producator isi rezerva pozitia cu un CAS pe enqueue_pos, scrie datele,
+ * apoi publica slotul setand seq (release). Consumatorii fac simetric acelasi
+ * lucru pe dequeue_pos. Nu exista lock: un thread oprit in mijlocul unei
+ * operatii blocheaza doar slotul lui.
+ */
+typedef struct mpmc_queue_t mpmc_queue_t;
+struct mpmc_queue_t {
+  /* Fiecare contor pe linia lui de cache, ca producatorii si consumatorii sa
+   * nu se incurce intre ei. */
+  _Alignas(CACHE_LINE) atomic_ulong enqueue_pos;
+  _Alignas(CACHE_LINE) atomic_ulong dequeue_pos;
+
+  /* Pentru asteptarile blocante: generatia creste la fiecare publicare /
+   * eliberare cand exista cineva care doarme pe ea. */
+  _Alignas(CACHE_LINE) atomic_uint items_gen;
+  atomic_uint items_waiters;
+  _Alignas(CACHE_LINE) atomic_uint slots_gen;
+  atomic_uint slots_waiters;
+
+  _Alignas(CACHE_LINE) unsigned int data_size;
+  /* Distanta in octeti intre doua sloturi (seq + date, aliniat la 8) */
+  unsigned int stride;
+  /* Capacitatea (o putere a lui 2) minus 1 */
+  unsigned long mask;
+  char *slots;
+};
+
+mpmc_queue_t *mq_create(unsigned int data_size, unsigned long capacity);
+int mq_try_enqueue(mpmc_queue_t *q, const void *new_data);
+int mq_try_dequeue(mpmc_queue_t *q, void *dst);
+unsigned long mq_enqueue_n(mpmc_queue_t *q, const void *src, unsigned long n);
+unsigned long mq_dequeue_n(mpmc_queue_t *q, void *dst, unsigned long n);
+void mq_enqueue(mpmc_queue_t *q, const void *new_data);
+void mq_dequeue(mpmc_queue_t *q, void *dst);
+void mq_free(mpmc_queue_t *q);
+
+static inline atomic_ulong *mq_seq(mpmc_queue_t *q, unsigned long pos) {
+  return (atomic_ulong *)(q->slots + (pos & q->mask) * q->stride);
+}
+
+static inline char *mq_data(mpmc_queue_t *q, unsigned long pos) {
+  return q->slots + (pos & q->mask) * q->stride + sizeof(atomic_ulong);
+}
+
+/* ------------------------------ futex ------------------------------ */
+
+#ifdef __linux__
+static void futex_wait(atomic_uint *addr, unsigned int val) {
+  syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+static void futex_wake(atomic_uint *addr, int count) {
+  syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+#else
+/* Fara futex, asteptarea degenereaza intr-un sched_yield. */
+static void futex_wait(atomic_uint *addr, unsigned int val) {
+  (void)addr;
+  (void)val;
+  sched_yield();
+}
+
+static void futex_wake(atomic_uint *addr, int count) {
+  (void)addr;
+  (void)count;
+}
+#endif
+
+/*
+ * Trezeste pana la count thread-uri care asteapta pe gen. Se apeleaza dupa ce
+ * starea cozii a fost publicata; bariera seq_cst impreuna cu cea din
+ * mq_wait garanteaza ca fie cel care asteapta vede noua stare, fie noi ii
+ * vedem inregistrarea in waiters.
+ */
+static void mq_notify(atomic_uint *gen, atomic_uint *waiters, unsigned long n) {
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(waiters, memory_order_relaxed) == 0) return;
+
+  atomic_fetch_add_explicit(gen, 1, memory_order_release);
+  futex_wake(gen, n > INT_MAX ? INT_MAX : (int)n);
+}
+
+/* --------------------------- operatii ----------------------------- */
+
+mpmc_queue_t *mq_create(unsigned int data_size, unsigned long capacity) {
+  mpmc_queue_t *q = aligned_alloc(CACHE_LINE, sizeof(*q));
+  unsigned long pow2 = 2;
+  DIE(!q, "aligned_alloc mpmc queue failed");
+
+  /* Capacitatea minima e 2: cu un singur slot, "liber pentru pos + 1" si
+   * "plin cu pos" ar avea acelasi seq. */
+  while (pow2 < capacity) pow2 <<= 1;
+
+  atomic_init(&q->enqueue_pos, 0);
+  atomic_init(&q->dequeue_pos, 0);
+  atomic_init(&q->items_gen, 0);
+  atomic_init(&q->items_waiters, 0);
+  atomic_init(&q->slots_gen, 0);
+  atomic_init(&q->slots_waiters, 0);
+  q->data_size = data_size;
+  q->stride = (sizeof(atomic_ulong) + data_size + 7) & ~7u;
+  q->mask = pow2 - 1;
+
+  q->slots = aligned_alloc(CACHE_LINE,
+                           (pow2 * q->stride + CACHE_LINE - 1) &
+                               ~(unsigned long)(CACHE_LINE - 1));
+  DIE(!q->slots, "aligned_alloc mpmc slots failed");
+
+  for (unsigned long i = 0; i < pow2; ++i) atomic_init(mq_seq(q, i), i);
+
+  return q;
+}
+
+/*
+ * Rezerva pana la n pozitii consecutive pe contorul pos, incepand de acolo
+ * unde sloturile au seq == pozitie + offset (offset 0 pentru producatori,
+ * 1 pentru consumatori). Intoarce cate pozitii a rezervat (0 daca nu exista
+ * niciuna disponibila) si prima dintre ele in *first.
+ */
+static unsigned long mq_claim(mpmc_queue_t *q, atomic_ulong *pos_ctr,
+                              unsigned long offset, unsigned long n,
+                              unsigned long *first) {
+  unsigned long pos = atomic_load_explicit(pos_ctr, memory_order_relaxed);
+
+  while (1) {
+    unsigned long k = 0;
+    long diff = 0;
+
+    /* Cate sloturi la rand sunt gata pentru pos, pos + 1, ... */
+    while (k < n && k <= q->mask) {
+      unsigned long seq =
+          atomic_load_explicit(mq_seq(q, pos + k), memory_order_acquire);
+      diff = (long)(seq - (pos + k + offset));
+      if (diff != 0) break;
+      ++k;
+    }
+
+    if (k == 0 && diff < 0) {
+      /* Primul slot nu e gata: coada e plina (producator) sau goala
+       * (consumator). */
+      return 0;
+    }
+
+    if (k == 0) {
+      /* Alt thread a rezervat deja pos; recitim contorul. */
+      pos = atomic_load_explicit(pos_ctr, memory_order_relaxed);
+      continue;
+    }
+
+    /* Un slot gata pentru pozitia pos + i poate fi revendicat doar de cine
+     * muta contorul peste pos + i, deci CAS-ul reusit ne da toate k
+     * sloturile. La esec, pos primeste valoarea curenta. */
+    if (atomic_compare_exchange_weak_explicit(pos_ctr, &pos, pos + k,
+                                              memory_order_relaxed,
+                                              memory_order_relaxed)) {
+      *first = pos;
+      return k;
+    }
+  }
+}
+
+/*
+ * Introduce pana la n elemente (n * data_size octeti de la src), in ordine,
+ * pe pozitii consecutive. Intoarce cate elemente au incaput; 0 inseamna ca
+ * coada era plina.
+ */
+unsigned long mq_enqueue_n(mpmc_queue_t *q, const void *src, unsigned long n) {
+  unsigned long pos, k;
+
+  k = mq_claim(q, &q->enqueue_pos, 0, n, &pos);
+  for (unsigned long i = 0; i < k; ++i) {
+    memcpy(mq_data(q, pos + i), (const char *)src + i * q->data_size,
+           q->data_size);
+    atomic_store_explicit(mq_seq(q, pos + i), pos + i + 1,
+                          memory_order_release);
+  }
+
+  if (k) mq_notify(&q->items_gen, &q->items_waiters, k);
+
+  return k;
+}
+
+/*
+ * Scoate pana la n elemente in dst, in ordinea in care au fost introduse.
+ * Intoarce cate elemente au fost scoase; 0 inseamna ca coada era goala.
+ */
+unsigned long mq_dequeue_n(mpmc_queue_t *q, void *dst, unsigned long n) {
+  unsigned long pos, k;
+
+  k = mq_claim(q, &q->dequeue_pos, 1, n, &pos);
+  for (unsigned long i = 0; i < k; ++i) {
+    memcpy((char *)dst + i * q->data_size, mq_data(q, pos + i), q->data_size);
+    atomic_store_explicit(mq_seq(q, pos + i), pos + i + q->mask + 1,
+                          memory_order_release);
+  }
+
+  if (k) mq_notify(&q->slots_gen, &q->slots_waiters, k);
+
+  return k;
+}
+
+/*
+ * Functia introduce un nou element in coada. Se va intoarce 1 daca operatia
+ * s-a efectuat cu succes si 0 daca coada este plina.
+ */
+int mq_try_enqueue(mpmc_queue_t *q, const void *new_data) {
+  return mq_enqueue_n(q, new_data, 1) != 0;
+}
+
+/*
+ * Functia scoate primul element din coada si il copiaza in dst. Se va
+ * intoarce 1 daca operatia s-a efectuat cu succes si 0 daca coada este goala.
+ */
+int mq_try_dequeue(mpmc_queue_t *q, void *dst) {
+  return mq_dequeue_n(q, dst, 1) != 0;
+}
+
+/*
+ * Asteapta pe gen pana cand try reuseste. Intai incearca de cateva ori fara
+ * sa doarma; apoi se inregistreaza in waiters si reincearca inainte de
+ * futex_wait, ca o notificare venita intre timp sa nu fie pierduta.
+ */
+static void mq_wait(mpmc_queue_t *q, atomic_uint *gen, atomic_uint *waiters,
+                    int (*try)(mpmc_queue_t *, void *), void *data) {
+  for (int i = 0; i < MQ_SPIN_COUNT; ++i)
+    if (try(q, data)) return;
+
+  while (1) {
+    unsigned int g = atomic_load_explicit(gen, memory_order_acquire);
+
+    atomic_fetch_add_explicit(waiters, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (try(q, data)) {
+      atomic_fetch_sub_explicit(waiters, 1, memory_order_relaxed);
+      return;
+    }
+
+    futex_wait(gen, g);
+    atomic_fetch_sub_explicit(waiters, 1, memory_order_relaxed);
+    if (try(q, data)) return;
+  }
+}
+
+static int mq_try_enqueue_cb(mpmc_queue_t *q, void *data) {
+  return mq_try_enqueue(q, data);
+}
+
+static int mq_try_dequeue_cb(mpmc_queue_t *q, void *data) {
+  return mq_try_dequeue(q, data);
+}
+
+/* Ca mq_try_enqueue, dar asteapta (dormind) pana se elibereaza un slot. */
+void mq_enqueue(mpmc_queue_t *q, const void *new_data) {
+  mq_wait(q, &q->slots_gen, &q->slots_waiters, mq_try_enqueue_cb,
+          (void *)new_data);
+}
+
+/* Ca mq_try_dequeue, dar asteapta (dormind) pana apare un element. */
+void mq_dequeue(mpmc_queue_t *q, void *dst) {
+  mq_wait(q, &q->items_gen, &q->items_waiters, mq_try_dequeue_cb, dst);
+}
+
+void mq_free(mpmc_queue_t *q) {
+  if (!q) return;
+
+  free(q->slots);
+  free(q);
+}
+
+/* ---------------------------- benchmark ---------------------------- */
+
+typedef struct {
+  mpmc_queue_t *q;
+  /* Elementele producatorului sunt start, start + 1, ..., end - 1 */
+  long start, end;
+  unsigned long batch;
+  int blocking;
+  /* Consumator: suma si numarul elementelor primite */
+  long sum, count;
+} bench_arg_t;
+
+static void *bench_producer(void *arg) {
+  bench_arg_t *a = arg;
+  long buf[BENCH_MAX_BATCH];
+
+  for (long i = a->start; i < a->end;) {
+    unsigned long n = a->batch, done = 0;
+
+    if ((long)n > a->end - i) n = a->end - i;
+    for (unsigned long j = 0; j < n; ++j) buf[j] = i + j;
+
+    if (n == 1 && a->blocking) {
+      mq_enqueue(a->q, buf);
+      done = 1;
+    }
+    while (done < n) {
+      unsigned long k = mq_enqueue_n(a->q, buf + done, n - done);
+      if (!k) sched_yield();
+      done += k;
+    }
+    i += n;
+  }
+
+  return NULL;
+}
+
+static void *bench_consumer(void *arg) {
+  bench_arg_t *a = arg;
+  long buf[BENCH_MAX_BATCH];
+
+  while (1) {
+    unsigned long k;
+
+    if (a->batch == 1 && a->blocking) {
+      mq_dequeue(a->q, buf);
+      k = 1;
+    } else {
+      k = mq_dequeue_n(a->q, buf, a->batch);
+      if (!k) {
+        sched_yield();
+        continue;
+      }
+    }
+
+    for (unsigned long j = 0; j < k; ++j) {
+      if (buf[j] != BENCH_STOP) {
+        a->sum += buf[j];
+        ++a->count;
+        continue;
+      }
+
+      /* Dupa primul BENCH_STOP urmeaza doar alte BENCH_STOP, destinate
+       * celorlalti consumatori; le punem inapoi. */
+      while (++j < k) mq_enqueue(a->q, &buf[j]);
+      return NULL;
+    }
+  }
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Trimite BENCH_ITEMS numere prin coada, de la producers producatori la
+ * consumers consumatori, si verifica ca fiecare a ajuns exact o data.
+ */
+static void bench_run(int producers, int consumers, unsigned long batch,
+                      int blocking) {
+  mpmc_queue_t *q = mq_create(sizeof(long), BENCH_CAPACITY);
+  pthread_t *threads = malloc((producers + consumers) * sizeof(*threads));
+  bench_arg_t *args = calloc(producers + consumers, sizeof(*args));
+  long stop = BENCH_STOP, sum = 0, count = 0;
+  long expected = (long)BENCH_ITEMS * (BENCH_ITEMS - 1) / 2;
+  double begin, secs;
+
+  DIE(!threads || !args, "bench malloc");
+
+  begin = now();
+  for (int i = 0; i < producers + consumers; ++i) {
+    args[i].q = q;
+    args[i].batch = batch;
+    args[i].blocking = blocking;
+    if (i < producers) {
+      args[i].start = (long)BENCH_ITEMS * i / producers;
+      args[i].end = (long)BENCH_ITEMS * (i + 1) / producers;
+    }
+    DIE(pthread_create(&threads[i], NULL,
+                       i < producers ? bench_producer : bench_consumer,
+                       &args[i]) != 0,
+        "pthread_create");
+  }
+
+  for (int i = 0; i < producers; ++i) pthread_join(threads[i], NULL);
+  /* Toate elementele sunt deja in coada, deci fiecare BENCH_STOP ajunge dupa
+   * ele la un consumator care nu se mai intoarce sa citeasca. */
+  for (int i = 0; i < consumers; ++i) mq_enqueue(q, &stop);
+  for (int i = producers; i < producers + consumers; ++i) {
+    pthread_join(threads[i], NULL);
+    sum += args[i].sum;
+    count += args[i].count;
+  }
+  secs = now() - begin;
+
+  printf("%2dP/%2dC batch %2lu %-8s %8.2f Mops/s %s\n", producers, consumers,
+         batch, blocking ? "blocking" : "spinning",
+         BENCH_ITEMS / secs / 1e6,
+         count == BENCH_ITEMS && sum == expected ? "ok" : "MISMATCH");
+
+  free(args);
+  free(threads);
+  mq_free(q);
+}
+
+/*
+ * Microbenchmark de contentie: ./mpmc_queue [producatori consumatori].
+ * Fara argumente ruleaza 1/1, 2/2 si 4/4 thread-uri.
+ */
+int main(int argc, char *argv[]) {
+  int configs[][2] = {{1, 1}, {2, 2}, {4, 4}};
+  int nconfigs = sizeof(configs) / sizeof(configs[0]);
+  unsigned long batches[] = {1, 16, BENCH_MAX_BATCH};
+
+  if (argc == 3) {
+    configs[0][0] = atoi(argv[1]);
+    configs[0][1] = atoi(argv[2]);
+    nconfigs = 1;
+    DIE(configs[0][0] < 1 || configs[0][1] < 1, "usage: mpmc_queue P C");
+  }
+
+  for (int c = 0; c < nconfigs; ++c)
+    for (int b = 0; b < 3; ++b)
+      for (int blocking = 0; blocking < 2; ++blocking) {
+        /* Varianta blocanta exista doar pentru operatii pe cate un element */
+        if (blocking && batches[b] != 1) continue;
+        bench_run(configs[c][0], configs[c][1], batches[b], blocking);
+      }
+
+  return 0;
+}
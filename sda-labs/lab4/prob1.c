@@ -13,6 +13,7 @@
   } while (0)
 
 #define MAX_STRING_SIZE 64
+#define STACK_INIT_CAPACITY 16
 
 typedef struct ll_node_t ll_node_t;
 struct ll_node_t {
@@ -170,60 +171,73 @@ void ll_print_string(linked_list_t* list) {
   printf("\n");
 }
 
+/*
+ * Stiva este un vector contiguu: elementele sunt stocate direct in buffer, la
+ * distanta de data_size octeti unul de altul, de la baza spre varf. Cand
+ * bufferul se umple, capacitatea se dubleaza, deci toate operatiile sunt O(1)
+ * amortizat.
+ */
 struct Stack {
-  linked_list_t* list;
+  /* Bufferul ce stocheaza elementele stivei */
+  void* data;
+  /* Dimensiunea in octeti a tipului de date stocat in stiva */
+  unsigned int data_size;
+  /* Numarul de elemente din stiva */
+  unsigned int size;
+  /* Numarul de elemente pentru care exista loc in buffer */
+  unsigned int capacity;
 };
 
 void init_stack(struct Stack* stack, unsigned int data_size) {
-  stack->list = ll_create(data_size);
+  stack->data_size = data_size;
+  stack->size = 0;
+  stack->capacity = STACK_INIT_CAPACITY;
+  stack->data = malloc((size_t)stack->capacity * data_size);
+  DIE(stack->data == NULL, "stack->data malloc");
 }
 
-int get_size_stack(struct Stack* stack) { return stack->list->size; }
+int get_size_stack(struct Stack* stack) { return stack->size; }
 
 int is_empty_stack(struct Stack* stack) {
-  if (stack->list->size == 0) {
+  if (stack->size == 0) {
     return 1;
   }
   return 0;
 }
 
 void* peek_stack(struct Stack* stack) {
-  if (stack == NULL) {
-    return NULL;
-  }
-  if (stack->list == NULL) {
+  if (stack == NULL || stack->size == 0) {
     return NULL;
   }
-  ll_node_t* node = stack->list->head;
-  while (node->next != NULL) {
-    node = node->next;
-  }
-  return node->data;
+  return (char*)stack->data + (size_t)(stack->size - 1) * stack->data_size;
 }
 
 void pop_stack(struct Stack* stack) {
-  if (stack == NULL || stack->list == NULL) {
+  if (stack == NULL || stack->size == 0) {
     return;
   }
-  ll_node_t* node = ll_remove_nth_node(stack->list, stack->list->size);
-  free(node);
+  stack->size--;
 }
 
 void push_stack(struct Stack* stack, void* new_data) {
-  ll_add_nth_node(stack->list, stack->list->size, new_data);
-}
-
-void clear_stack(struct Stack* stack) {
-  ll_node_t* node;
-  while (is_empty_stack(stack) == 0) {
-    node = ll_remove_nth_node(stack->list, 0);
-    free(node);
+  if (stack->size == stack->capacity) {
+    stack->capacity *= 2;
+    stack->data =
+        realloc(stack->data, (size_t)stack->capacity * stack->data_size);
+    DIE(stack->data == NULL, "stack->data realloc");
   }
+  memcpy((char*)stack->data + (size_t)stack->size * stack->data_size,
+         new_data, stack->data_size);
+  stack->size++;
 }
 
+void clear_stack(struct Stack* stack) { stack->size = 0; }
+
 void purge_stack(struct Stack* stack) {
   clear_stack(stack);
-  free(stack->list);
+  free(stack->data);
+  stack->data = NULL;
+  stack->capacity = 0;
 }
 
 int main() {
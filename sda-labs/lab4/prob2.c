@@ -19,7 +19,7 @@
 
 typedef struct queue_t queue_t;
 struct queue_t {
-  /* Dimensiunea maxima a cozii */
+  /* Dimensiunea maxima a cozii; 0 inseamna fara limita */
   unsigned int max_size;
   /* Dimensiunea cozii */
   unsigned int size;
@@ -29,22 +29,63 @@ struct queue_t {
   unsigned int read_idx;
   /* Indexul de la care se vor efectua operatiile de enqueue */
   unsigned int write_idx;
-  /* Bufferul ce stocheaza elementele cozii */
-  void **buff;
+  /* Capacitatea bufferului (o putere a lui 2) minus 1 */
+  unsigned int mask;
+  /* Bufferul ce stocheaza elementele cozii, unul dupa altul, cate
+   * data_size octeti fiecare */
+  void *buff;
 };
 
-queue_t *q_create(unsigned int data_size, unsigned int max_size) {
-  queue_t *coada = malloc(sizeof(*coada));
-  coada->max_size = max_size;
-  coada->size = 0;
-  coada->data_size = data_size;
-  coada->read_idx = 0;
-  coada->write_idx = 0;
-  coada->buff = malloc(sizeof(void *) * max_size);
-  for (int i = 0; i < max_size; i++) {
-    coada->buff[i] = malloc(data_size);
-  }
-  return coada;
+queue_t *q_create(unsigned int data_size, unsigned int capacity) {
+  queue_t *q = calloc(1, sizeof(*q));
+  unsigned int pow2 = 1;
+  DIE(!q, "calloc queue failed");
+
+  /* capacity este doar capacitatea initiala, coada creste la nevoie. Se
+   * rotunjeste la o putere a lui 2, ca indecsii sa avanseze prin masca. */
+  while (pow2 < capacity) pow2 <<= 1;
+
+  q->data_size = data_size;
+  q->mask = pow2 - 1;
+
+  q->buff = malloc((size_t)pow2 * data_size);
+  DIE(!q->buff, "malloc buffer failed");
+
+  return q;
+}
+
+/*
+ * Limiteaza coada la cel mult max_size elemente (0 = fara limita, implicit).
+ * Peste limita, q_enqueue refuza noile elemente. O limita mai mica decat
+ * dimensiunea curenta nu elimina nimic, dar blocheaza adaugarile pana cand
+ * coada scade sub ea.
+ */
+void q_set_max_size(queue_t *q, unsigned int max_size) {
+  if (q) q->max_size = max_size;
+}
+
+/*
+ * Dubleaza capacitatea cozii. Elementele sunt copiate in ordine in noul
+ * buffer, incepand de la pozitia 0, deci coada nu mai este "rupta" la finalul
+ * bufferului.
+ */
+static void q_grow(queue_t *q) {
+  unsigned int capacity = q->mask + 1;
+  unsigned int first = capacity - q->read_idx;
+  char *buff = malloc((size_t)2 * capacity * q->data_size);
+  DIE(!buff, "malloc buffer failed");
+
+  if (first > q->size) first = q->size;
+  memcpy(buff, (char *)q->buff + (size_t)q->read_idx * q->data_size,
+         (size_t)first * q->data_size);
+  memcpy(buff + (size_t)first * q->data_size, q->buff,
+         (size_t)(q->size - first) * q->data_size);
+
+  free(q->buff);
+  q->buff = buff;
+  q->read_idx = 0;
+  q->write_idx = q->size;
+  q->mask = 2 * capacity - 1;
 }
 
 /*
@@ -67,7 +108,11 @@ unsigned int q_is_empty(queue_t *q) {
 /*
  * Functia intoarce primul element din coada, fara sa il elimine.
  */
-void *q_front(queue_t *q) { return q->buff[q->read_idx]; }
+void *q_front(queue_t *q) {
+  if (!q || !q->size) return NULL;
+
+  return (char *)q->buff + (size_t)q->read_idx * q->data_size;
+}
 
 /*
  * Functia scoate un element din coada. Se va intoarce 1 daca operatia s-a
@@ -75,12 +120,10 @@ void *q_front(queue_t *q) { return q->buff[q->read_idx]; }
  * 0 in caz contrar.
  */
 int q_dequeue(queue_t *q) {
-  if (q->size == 0) {
-    return 0;
-  }
-  free(q->buff[q->read_idx]);
-  q->read_idx = (q->read_idx + 1) % q->max_size;
-  q->size--;
+  if (!q || !q->size) return 0;
+
+  q->read_idx = (q->read_idx + 1) & q->mask;
+  --q->size;
   return 1;
 }
 
@@ -90,29 +133,36 @@ int q_dequeue(queue_t *q) {
  * si 0 in caz contrar.
  */
 int q_enqueue(queue_t *q, void *new_data) {
-  if (q->size == q->max_size) {
-    return 0;
-  }
-  memcpy(q->buff[q->write_idx], new_data, q->data_size);
-  q->write_idx = (q->write_idx + 1) % q->max_size;
-  q->size++;
+  if (!q || (q->max_size && q->size >= q->max_size)) return 0;
+
+  if (q->size == q->mask + 1) q_grow(q);
+
+  memcpy((char *)q->buff + (size_t)q->write_idx * q->data_size, new_data,
+         q->data_size);
+  q->write_idx = (q->write_idx + 1) & q->mask;
+  ++q->size;
+
+  return 1;
 }
 
 /*
  * Functia elimina toate elementele din coada primita ca parametru.
  */
 void q_clear(queue_t *q) {
-  for (int i = 0; i < q->size; i++) {
-    free(q->buff[i]);
-  }
-  free(q->buff);
+  if (!q) return;
+
+  q->read_idx = 0;
+  q->write_idx = 0;
+  q->size = 0;
 }
 
 /*
  * Functia elibereaza toata memoria ocupata de coada.
  */
 void q_free(queue_t *q) {
-  q_clear(q);
+  if (!q) return;
+
+  free(q->buff);
   free(q);
 }
 
@@ -162,6 +212,6 @@ int main() {
     printf("%d\n", q_get_size(q));
   }
 
-  free(q);
+  q_free(q);
   return 0;
 }
\ No newline at end of file
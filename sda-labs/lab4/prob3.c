@@ -1,7 +1,13 @@
 #include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 #define DIE(assertion, call_description)                 \
   do {                                                   \
@@ -13,6 +19,10 @@
   } while (0)
 
 #define MAX_STRING_SIZE 64
+#define STACK_INIT_CAPACITY 16
+#define IN_BLOCK_SIZE (1 << 20)
+#define OUT_BLOCK_SIZE (1 << 16)
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
 
 typedef struct ll_node_t ll_node_t;
 struct ll_node_t {
@@ -144,25 +154,44 @@ void ll_print_int(linked_list_t* list) {
   printf("\n");
 }
 
+/*
+ * Stiva este un vector contiguu: elementele sunt stocate direct in buffer, la
+ * distanta de data_size octeti unul de altul, de la baza spre varf. Cand
+ * bufferul se umple, capacitatea se dubleaza, deci toate operatiile sunt O(1)
+ * amortizat. size si capacity sunt size_t, ca dublarea sa nu dea peste cap
+ * dupa 2^31 de elemente.
+ */
 struct Stack {
-  linked_list_t* list;
+  /* Bufferul ce stocheaza elementele stivei */
+  void* data;
+  /* Dimensiunea in octeti a tipului de date stocat in stiva */
+  unsigned int data_size;
+  /* Numarul de elemente din stiva */
+  size_t size;
+  /* Numarul de elemente pentru care exista loc in buffer */
+  size_t capacity;
 };
 
-typedef struct {
+/*
+ * O secventa de nr caractere c. Structura e impachetata (5 octeti in loc de
+ * 8), pentru ca pe intrari fara repetitii stiva are aproape cate o intrare
+ * pentru fiecare caracter citit.
+ */
+typedef struct __attribute__((packed)) {
   char c;
-  int nr;
+  uint32_t nr;
 } caracter_t;
 
-void ll_print_string(struct Stack* stack) {
-  ll_node_t* curr = stack->list->head;
+/* Cea mai lunga secventa care incape intr-o intrare din stiva. */
+#define RUN_MAX UINT32_MAX
 
+void ll_print_string(struct Stack* stack) {
   if (stack == NULL) {
     return;
   }
 
-  while (curr != NULL) {
-    printf("%c", ((caracter_t*)curr->data)->c);
-    curr = curr->next;
+  for (size_t i = 0; i < stack->size; i++) {
+    printf("%c", ((caracter_t*)stack->data)[i].c);
   }
 
   printf("\n");
@@ -172,114 +201,375 @@ void ll_print_string(struct Stack* stack) {
  * ----------------------------------------*/
 
 void init_stack(struct Stack* stack, unsigned int data_size) {
-  stack->list = ll_create(data_size);
+  stack->data_size = data_size;
+  stack->size = 0;
+  stack->capacity = STACK_INIT_CAPACITY;
+  stack->data = malloc((size_t)stack->capacity * data_size);
+  DIE(stack->data == NULL, "stack->data malloc");
 }
 
-int get_size_stack(struct Stack* stack) {
-  /* TODO */
-  return stack->list->size;
-}
+size_t get_size_stack(struct Stack* stack) { return stack->size; }
 
 int is_empty_stack(struct Stack* stack) {
-  if (stack->list->size == 0) {
+  if (stack->size == 0) {
     return 1;
   }
   return 0;
 }
 
 void* peek_stack(struct Stack* stack) {
-  if (stack == NULL) {
-    return NULL;
-  }
-  if (stack->list == NULL) {
+  if (stack == NULL || stack->size == 0) {
     return NULL;
   }
-  ll_node_t* node = stack->list->head;
-  while (node->next != NULL) {
-    node = node->next;
-  }
-  return node->data;
+  return (char*)stack->data + (stack->size - 1) * stack->data_size;
 }
 
 void pop_stack(struct Stack* stack) {
-  if (stack == NULL || stack->list == NULL) {
+  if (stack == NULL || stack->size == 0) {
     return;
   }
-  ll_node_t* node = ll_remove_nth_node(stack->list, stack->list->size);
-  free(node);
+  stack->size--;
 }
 
 void push_stack(struct Stack* stack, void* new_data) {
-  ll_add_nth_node(stack->list, stack->list->size, new_data);
-}
-
-void clear_stack(struct Stack* stack) {
-  /* TODO */
-  struct ll_node_t* node;
-  while (!is_empty_stack(stack)) {
-    node = ll_remove_nth_node(stack->list, 0);
-    free(node);
+  if (stack->size == stack->capacity) {
+    stack->capacity *= 2;
+    stack->data = realloc(stack->data, stack->capacity * stack->data_size);
+    DIE(stack->data == NULL, "stack->data realloc");
   }
+  memcpy((char*)stack->data + stack->size * stack->data_size, new_data,
+         stack->data_size);
+  stack->size++;
 }
 
+void clear_stack(struct Stack* stack) { stack->size = 0; }
+
 void purge_stack(struct Stack* stack) {
-  /* TODO */
   clear_stack(stack);
-  free(stack->list);
+  free(stack->data);
+  stack->data = NULL;
+  stack->capacity = 0;
 }
 
 /*
- * Functie care sterge duplicatele de dimensiun k dintr-un sir
+ * Scrie in out continutul stivei de secvente, de la baza spre varf, printr-un
+ * buffer de dimensiune fixa (OUT_BLOCK_SIZE). Secventele de un caracter, cele
+ * mai dese pe intrari fara repetitii, se copiaza direct, fara memset.
  */
+static void write_runs(struct Stack* stack, FILE* out) {
+  static char buf[OUT_BLOCK_SIZE];
+  size_t len = 0;
 
-void removeDuplicates(char* s, int k) {
-  struct Stack* stack = malloc(sizeof(*stack));
+  for (size_t poz = 0; poz < stack->size; poz++) {
+    caracter_t* a = (caracter_t*)stack->data + poz;
+    size_t left = a->nr;
 
-  init_stack(stack, sizeof(caracter_t));
+    if (left == 1 && len < OUT_BLOCK_SIZE - 1) {
+      buf[len++] = a->c;
+      continue;
+    }
+    while (left > 0) {
+      size_t chunk = MIN(left, OUT_BLOCK_SIZE - len);
+
+      memset(buf + len, a->c, chunk);
+      len += chunk;
+      left -= chunk;
+      if (len == OUT_BLOCK_SIZE) {
+        fwrite(buf, 1, len, out);
+        len = 0;
+      }
+    }
+  }
+  fwrite(buf, 1, len, out);
+}
+
+/* Echivalentul lui isspace in locale-ul "C", fara apel de functie. */
+static inline int is_blank(char c) {
+  return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t';
+}
+
+/*
+ * Pune o intrare noua (c, nr) in varful stivei si intoarce pointer la ea.
+ * Intrarea se scrie direct in buffer, fara memcpy de data_size octeti.
+ */
+static inline caracter_t* push_caracter(struct Stack* stack, char c,
+                                        size_t nr) {
+  caracter_t* a;
+
+  if (stack->size == stack->capacity) {
+    stack->capacity *= 2;
+    stack->data = realloc(stack->data, stack->capacity * sizeof(caracter_t));
+    DIE(stack->data == NULL, "stack->data realloc");
+  }
+  a = (caracter_t*)stack->data + stack->size++;
+  a->c = c;
+  a->nr = nr;
+  return a;
+}
+
+/*
+ * Adauga peste varful stivei o secventa de len caractere c consecutive (c nu
+ * este spatiu alb). Daca varful contine acelasi caracter, secventele se unesc;
+ * din fiecare grup se elimina atatea blocuri complete de k caractere cate se
+ * pot, deci o secventa lunga costa o singura operatie, nu cate una pentru
+ * fiecare caracter. Impartirea la k se face doar cand grupul are cel putin k
+ * caractere, adica rar pe intrari cu secvente scurte.
+ */
+static inline void push_run(struct Stack* stack, caracter_t** top, char c,
+                            size_t len, int k) {
+  if (*top != NULL && (*top)->c == c) {
+    size_t total = (*top)->nr + len;
+
+    if (k > 0 && total >= (size_t)k) total %= k;
+    if (total == 0) {
+      pop_stack(stack);
+      *top = peek_stack(stack);
+      return;
+    }
+    if (total <= RUN_MAX) {
+      (*top)->nr = total;
+      return;
+    }
+    /* Doar cu k <= 0: secventa nu mai incape, continua intr-o intrare noua. */
+    (*top)->nr = RUN_MAX;
+    len = total - RUN_MAX;
+  } else if (k > 0 && len >= (size_t)k) {
+    len %= k;
+    if (len == 0) return;
+  }
+
+  *top = push_caracter(stack, c, len);
+}
+
+/*
+ * Varianta caracter cu caracter: fiecare caracter e tratat ca o secventa de
+ * lungime 1. Este bucla initiala din removeDuplicates, pastrata ca referinta
+ * pentru --bench.
+ */
+static void push_chars(struct Stack* stack, caracter_t** top, const char* p,
+                       size_t len, int k) {
+  for (size_t i = 0; i < len; i++) {
+    char c = p[i];
 
-  int i, j;
-  caracter_t* a = malloc(sizeof(caracter_t));
-  for (i = 0; i < strlen(s); i++) {
-    if (get_size_stack(stack) == 0) {
-      a->c = s[i];
-      a->nr = 1;
-      push_stack(stack, a);
-    } else {
-      a = peek_stack(stack);
-      if (s[i] == a->c) {
-        a->nr++;
+    if (is_blank(c)) continue;
+
+    if (*top != NULL && (*top)->c == c && (*top)->nr < RUN_MAX) {
+      if (++(*top)->nr == (uint32_t)k && k > 0) {
         pop_stack(stack);
-        push_stack(stack, a);
-
-        if (a->nr == k) {
-          pop_stack(stack);
-        }
-      } else {
-        a->c = s[i];
-        a->nr = 1;
-        push_stack(stack, a);
+        *top = peek_stack(stack);
       }
+    } else if (k != 1) {
+      *top = push_caracter(stack, c, 1);
     }
   }
-  ll_node_t* node = stack->list->head;
-  while (node != NULL) {
-    a = node->data;
-    for (i = 0; i < a->nr; i++) {
-      printf("%c", a->c);
+}
+
+/*
+ * Imparte blocul p[0..len) in secvente maximale de caractere egale si le da
+ * pe rand lui push_run; secventele de spatii albe se sar. Granitele dintre
+ * secvente (pozitiile i cu p[i] != p[i - 1]) se gasesc cate 32 (AVX2) sau 16
+ * (SSE2) deodata: blocul se compara cu el insusi deplasat cu un octet, iar
+ * bitii din masca rezultata se parcurg cu ctz. In acelasi pas se calculeaza
+ * si masca spatiilor albe, din care se afla daca secventa care incepe la o
+ * granita trebuie sarita. Cand peste jumatate din pozitii sunt granite
+ * (secvente de 1-2 caractere, ca pe text aleator), bucata se da lui
+ * push_chars, care e mai ieftin pe caracter decat push_run pe secventa.
+ * Restul blocului, si platformele fara SSE2, trec prin bucla scalara.
+ */
+static void push_block(struct Stack* stack, caracter_t** top, const char* p,
+                       size_t len, int k) {
+  size_t start = 0, i = 1;
+  int skip;
+
+  if (len == 0) return;
+  skip = is_blank(p[0]);
+
+#ifdef __AVX2__
+  {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i span = _mm256_set1_epi8('\r' - '\t');
+
+    for (; i + 32 <= len; i += 32) {
+      __m256i cur = _mm256_loadu_si256((const __m256i*)(p + i));
+      __m256i prev = _mm256_loadu_si256((const __m256i*)(p + i - 1));
+      __m256i ctl = _mm256_sub_epi8(cur, tab);
+      __m256i blank = _mm256_or_si256(
+          _mm256_cmpeq_epi8(cur, space),
+          _mm256_cmpeq_epi8(_mm256_min_epu8(ctl, span), ctl));
+      unsigned int mask =
+          ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(cur, prev));
+      unsigned int blanks = _mm256_movemask_epi8(blank);
+
+      if (__builtin_popcount(mask) > 32 / 2) {
+        size_t last = i + 31 - __builtin_clz(mask);
+
+        push_chars(stack, top, p + start, last - start, k);
+        start = last;
+        skip = (blanks >> (last - i)) & 1;
+        continue;
+      }
+      for (; mask != 0; mask &= mask - 1) {
+        unsigned int bit = __builtin_ctz(mask);
+        size_t b = i + bit;
+
+        if (!skip) push_run(stack, top, p[start], b - start, k);
+        start = b;
+        skip = (blanks >> bit) & 1;
+      }
     }
-    node = node->next;
   }
-  printf("\n");
+#endif
+#ifdef __SSE2__
+  {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i span = _mm_set1_epi8('\r' - '\t');
+
+    for (; i + 16 <= len; i += 16) {
+      __m128i cur = _mm_loadu_si128((const __m128i*)(p + i));
+      __m128i prev = _mm_loadu_si128((const __m128i*)(p + i - 1));
+      __m128i ctl = _mm_sub_epi8(cur, tab);
+      __m128i blank =
+          _mm_or_si128(_mm_cmpeq_epi8(cur, space),
+                       _mm_cmpeq_epi8(_mm_min_epu8(ctl, span), ctl));
+      unsigned int mask =
+          ~(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(cur, prev)) & 0xFFFF;
+      unsigned int blanks = _mm_movemask_epi8(blank);
+
+      if (__builtin_popcount(mask) > 16 / 2) {
+        size_t last = i + 31 - __builtin_clz(mask);
+
+        push_chars(stack, top, p + start, last - start, k);
+        start = last;
+        skip = (blanks >> (last - i)) & 1;
+        continue;
+      }
+      for (; mask != 0; mask &= mask - 1) {
+        unsigned int bit = __builtin_ctz(mask);
+        size_t b = i + bit;
+
+        if (!skip) push_run(stack, top, p[start], b - start, k);
+        start = b;
+        skip = (blanks >> bit) & 1;
+      }
+    }
+  }
+#endif
+
+  for (; i < len; i++) {
+    if (p[i] != p[i - 1]) {
+      if (!skip) push_run(stack, top, p[start], i - start, k);
+      start = i;
+      skip = is_blank(p[i]);
+    }
+  }
+  if (!skip) push_run(stack, top, p[start], len - start, k);
 }
 
-int main() {
-  char s[64];
+/*
+ * Sterge duplicatele de dimensiune k din sirul citit din in si scrie
+ * rezultatul in out, cu push_block (runs != 0) sau cu push_chars.
+ */
+static void remove_duplicates(FILE* in, FILE* out, int k, int runs) {
+  static char block[IN_BLOCK_SIZE];
+  struct Stack* stack = malloc(sizeof(*stack));
+  caracter_t* top = NULL;
+  size_t len;
+
+  DIE(stack == NULL, "stack malloc");
+  init_stack(stack, sizeof(caracter_t));
+
+  while ((len = fread(block, 1, IN_BLOCK_SIZE, in)) > 0) {
+    if (runs)
+      push_block(stack, &top, block, len, k);
+    else
+      push_chars(stack, &top, block, len, k);
+  }
+
+  write_runs(stack, out);
+  fputc('\n', out);
+
+  purge_stack(stack);
+  free(stack);
+}
+
+/*
+ * Functie care sterge duplicatele de dimensiune k din sirul citit din in si
+ * scrie rezultatul in out.
+ *
+ * Sirul este citit in blocuri de IN_BLOCK_SIZE octeti, deci poate avea orice
+ * lungime; spatiile albe sunt ignorate. Stiva retine perechi (caracter,
+ * numar de aparitii consecutive), asa ca ocupa memorie doar pentru secventele
+ * care supravietuiesc, nu pentru fiecare caracter. Rezultatul poate fi scris
+ * abia la final (un caracter de la sfarsit poate anula secvente de la
+ * inceput), dar iesirea trece tot printr-un buffer de dimensiune fixa.
+ */
+void removeDuplicates(FILE* in, FILE* out, int k) {
+  remove_duplicates(in, out, k, 1);
+}
+
+/*
+ * Compara, cap la cap (citire, stiva, scriere), bucla caracter cu caracter
+ * (push_chars) cu varianta pe secvente (push_block), pe cateva tipuri de
+ * intrari generate in memorie. Intrarea se citeste cu fmemopen, iesirea merge
+ * in /dev/null. Se ruleaza cu ./prob3 --bench.
+ */
+static void bench(void) {
+  const size_t len = 64 << 20;
+  const char* names[] = {"random a-z", "random ab (adversarial)",
+                         "alternating ab", "runs of 1000"};
+  char* buf = malloc(len);
+  FILE* out = fopen("/dev/null", "w");
+
+  DIE(buf == NULL, "bench malloc");
+  DIE(out == NULL, "fopen /dev/null");
+  srand(42);
+
+  for (int t = 0; t < 4; t++) {
+    for (size_t i = 0; i < len; i++) {
+      if (t == 0)
+        buf[i] = 'a' + rand() % 26;
+      else if (t == 1)
+        buf[i] = 'a' + rand() % 2;
+      else if (t == 2)
+        buf[i] = 'a' + i % 2;
+      else
+        buf[i] = 'a' + (i / 1000) % 26;
+    }
+
+    printf("%-24s", names[t]);
+    for (int runs = 0; runs < 2; runs++) {
+      FILE* in = fmemopen(buf, len, "r");
+      clock_t begin;
+      double secs;
+
+      DIE(in == NULL, "fmemopen");
+      begin = clock();
+      remove_duplicates(in, out, 3, runs);
+      secs = (double)(clock() - begin) / CLOCKS_PER_SEC;
+      printf(" %s: %8.1f MB/s", runs ? "runs" : "chars",
+             len / (1024.0 * 1024.0) / secs);
+      fclose(in);
+    }
+    printf("\n");
+  }
+
+  fclose(out);
+  free(buf);
+}
+
+int main(int argc, char* argv[]) {
   int k;
 
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+    bench();
+    return 0;
+  }
+
   scanf("%d", &k);
-  scanf("%s", s);
 
-  removeDuplicates(s, k);
+  removeDuplicates(stdin, stdout, k);
 
   return 0;
 }
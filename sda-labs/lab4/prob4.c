@@ -13,6 +13,7 @@
   } while (0)
 
 #define MAX_STRING_SIZE 64
+#define STACK_INIT_CAPACITY 16
 
 typedef struct ll_node_t ll_node_t;
 struct ll_node_t {
@@ -173,67 +174,73 @@ void ll_print_string(linked_list_t* list) {
 /* ---------------------------------- TODO: Stack implementation
  * ----------------------------------------*/
 
+/*
+ * Stiva este un vector contiguu: elementele sunt stocate direct in buffer, la
+ * distanta de data_size octeti unul de altul, de la baza spre varf. Cand
+ * bufferul se umple, capacitatea se dubleaza, deci toate operatiile sunt O(1)
+ * amortizat.
+ */
 struct Stack {
-  linked_list_t* list;
+  /* Bufferul ce stocheaza elementele stivei */
+  void* data;
+  /* Dimensiunea in octeti a tipului de date stocat in stiva */
+  unsigned int data_size;
+  /* Numarul de elemente din stiva */
+  unsigned int size;
+  /* Numarul de elemente pentru care exista loc in buffer */
+  unsigned int capacity;
 };
 
 void init_stack(struct Stack* stack, unsigned int data_size) {
-  stack->list = ll_create(data_size);
+  stack->data_size = data_size;
+  stack->size = 0;
+  stack->capacity = STACK_INIT_CAPACITY;
+  stack->data = malloc((size_t)stack->capacity * data_size);
+  DIE(stack->data == NULL, "stack->data malloc");
 }
 
-int get_size_stack(struct Stack* stack) {
-  /* TODO */
-  return stack->list->size;
-}
+int get_size_stack(struct Stack* stack) { return stack->size; }
 
 int is_empty_stack(struct Stack* stack) {
-  /* TODO */
-  return get_size_stack(stack) == 0;
+  if (stack->size == 0) {
+    return 1;
+  }
+  return 0;
 }
 
 void* peek_stack(struct Stack* stack) {
-  /* TODO */
-  if (stack == NULL || stack->list == NULL) {
+  if (stack == NULL || stack->size == 0) {
     return NULL;
   }
-
-  ll_node_t* node = stack->list->head;
-  while (node->next != NULL) {
-    node = node->next;
-  }
-  return node->data;
+  return (char*)stack->data + (size_t)(stack->size - 1) * stack->data_size;
 }
 
 void pop_stack(struct Stack* stack) {
-  /* TODO */
-  struct ll_node_t* node;
-
-  if (stack == NULL || stack->list == NULL) {
+  if (stack == NULL || stack->size == 0) {
     return;
   }
-
-  node = ll_remove_nth_node(stack->list, stack->list->size - 1);
-  free(node);
+  stack->size--;
 }
 
 void push_stack(struct Stack* stack, void* new_data) {
-  /* TODO */
-  ll_add_nth_node(stack->list, stack->list->size, new_data);
-}
-
-void clear_stack(struct Stack* stack) {
-  /* TODO */
-  struct ll_node_t* node;
-  while (!is_empty_stack(stack)) {
-    node = ll_remove_nth_node(stack->list, 0);
-    free(node);
+  if (stack->size == stack->capacity) {
+    stack->capacity *= 2;
+    stack->data =
+        realloc(stack->data, (size_t)stack->capacity * stack->data_size);
+    DIE(stack->data == NULL, "stack->data realloc");
   }
+  memcpy((char*)stack->data + (size_t)stack->size * stack->data_size,
+         new_data, stack->data_size);
+  stack->size++;
 }
 
+void clear_stack(struct Stack* stack) { stack->size = 0; }
+
 void purge_stack(struct Stack* stack) {
-  /* TODO */
   clear_stack(stack);
-  free(stack->list);
+  free(stack->data);
+  stack->data = NULL;
+  stack->capacity = 0;
 }
 
 /*
@@ -247,13 +254,11 @@ void removeDuplicates(char* s, int k) {
   struct Stack* stack = malloc(sizeof(*stack));
   init_stack(stack, sizeof(caracter_t));
 
-  int i, j;
+  int i;
   for (i = 0; i < strlen(s); i++) {
     if (get_size_stack(stack) == 0) {
-      caracter_t* a = malloc(sizeof(caracter_t));
-      a->c = s[i];
-      a->nr = 1;
-      push_stack(stack, a);
+      caracter_t a = {s[i], 1};
+      push_stack(stack, &a);
     } else {
       caracter_t* a = peek_stack(stack);
       if (s[i] == a->c) {
@@ -264,23 +269,22 @@ void removeDuplicates(char* s, int k) {
         }
 
       } else {
-        a = malloc(sizeof(caracter_t));
-        a->c = s[i];
-        a->nr = 1;
-        push_stack(stack, a);
+        caracter_t b = {s[i], 1};
+        push_stack(stack, &b);
       }
     }
   }
 
-  ll_node_t* node = stack->list->head;
-  while (node != NULL) {
-    caracter_t* a = node->data;
+  for (unsigned int poz = 0; poz < stack->size; poz++) {
+    caracter_t* a = (caracter_t*)stack->data + poz;
     for (i = 0; i < a->nr; i++) {
       printf("%c", a->c);
     }
-    node = node->next;
   }
   printf("\n");
+
+  purge_stack(stack);
+  free(stack);
 }
 
 int main() {
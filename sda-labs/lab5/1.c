@@ -1,17 +1,91 @@
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
-#define INF 999
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * "Infinit" pentru distante. Toate distantele stau in [0, INF], iar suma a
+ * doua astfel de valori nu depaseste INT_MAX, deci adunarea urmata de minim
+ * cu INF (dist_add) este o adunare saturata: un drum care trece prin INF
+ * ramane INF, oricat de lung ar fi restul.
+ */
+#define INF (INT_MAX / 2)
 #define MAX_STRING_SIZE 256
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+/* Latura unui bloc Floyd-Warshall (multiplu de ROW_INTS) */
+#define FW_BLOCK 64
+#define FW_MAX_THREADS 64
+/* Randurile matricei incep la o linie de cache si au ROW_INTS int-uri */
+#define ROW_ALIGN 64
+#define ROW_INTS (ROW_ALIGN / (int)sizeof(int))
+
+/*
+ * Matricea este stocata rand dupa rand intr-o singura alocare aliniata.
+ * Fiecare rand are stride >= nodes elemente (multiplu de ROW_INTS); coloanele
+ * de la nodes la stride - 1 sunt doar completare si contin INF.
+ */
 typedef struct {
-  int** matrix; /* Matricea de adiacenta a grafului */
-  int nodes;    /* Numarul de noduri din graf. */
+  int* matrix; /* Matricea de adiacenta a grafului */
+  int nodes;   /* Numarul de noduri din graf. */
+  int stride;  /* Distanta, in elemente, intre inceputurile a doua randuri */
 } matrix_graph_t;
 
+/* Randul nodului node din matricea de adiacenta */
+static inline int* mg_row(matrix_graph_t* graph, int node) {
+  return graph->matrix + (size_t)node * graph->stride;
+}
+
+/*
+ * Umple count int-uri de la dst (aliniat la ROW_ALIGN, count multiplu de
+ * ROW_INTS) cu value, cate 8 sau 4 odata daca exista AVX2 / SSE2.
+ */
+static void fill_int(int* dst, int value, size_t count) {
+  size_t i = 0;
+#ifdef __AVX2__
+  __m256i v8 = _mm256_set1_epi32(value);
+  for (; i + 8 <= count; i += 8) _mm256_store_si256((__m256i*)(dst + i), v8);
+#endif
+#ifdef __SSE2__
+  __m128i v4 = _mm_set1_epi32(value);
+  for (; i + 4 <= count; i += 4) _mm_store_si128((__m128i*)(dst + i), v4);
+#endif
+  for (; i < count; i++) dst[i] = value;
+}
+
+/*
+ * Aloca rows randuri aliniate la ROW_ALIGN, fiecare cu cols elemente de
+ * elem_size octeti, completate pana la un multiplu de ROW_ALIGN octeti. Pune
+ * in *stride numarul de elemente dintr-un rand si in *bytes dimensiunea
+ * totala. Intoarce NULL daca dimensiunile nu incap (stride in int, totalul in
+ * size_t) sau daca alocarea esueaza.
+ */
+static void* alloc_rows(int rows, int cols, int elem_size, int* stride,
+                        size_t* bytes) {
+  size_t per_row = ROW_ALIGN / elem_size;
+  size_t row_elems;
+
+  if (rows < 0 || cols < 0) return NULL;
+  row_elems = ((size_t)cols + per_row - 1) / per_row * per_row;
+  if (row_elems > INT_MAX) return NULL;
+  if (rows && row_elems * elem_size > SIZE_MAX / rows) return NULL;
+
+  *stride = (int)row_elems;
+  *bytes = (size_t)rows * row_elems * elem_size;
+  return aligned_alloc(ROW_ALIGN, *bytes ? *bytes : ROW_ALIGN);
+}
+
 /**
  * Initializeaza graful cu numarul de noduri primit ca parametru si aloca
- * memorie pentru matricea de adiacenta a grafului.
+ * memorie pentru matricea de adiacenta a grafului. Intoarce NULL daca nu
+ * exista destula memorie.
  */
 
 /* Graful este ORIENTAT */
@@ -20,67 +94,961 @@ typedef struct {
 
 matrix_graph_t* mg_create(int nodes) {
   matrix_graph_t* mg = malloc(sizeof(matrix_graph_t));
+  size_t bytes;
+
+  if (!mg) return NULL;
   mg->nodes = nodes;
-  mg->matrix = (int**)malloc(sizeof(int*) * nodes);
-  for (int i = 0; i < nodes; i++) {
-    mg->matrix[i] = (int*)malloc(sizeof(int) * nodes);
-  }
-  for (int i = 0; i < nodes; i++) {
-    for (int j = 0; j < nodes; j++) {
-      mg->matrix[i][j] = INF;
-    }
+  mg->matrix = alloc_rows(nodes, nodes, sizeof(int), &mg->stride, &bytes);
+  if (!mg->matrix) {
+    free(mg);
+    return NULL;
   }
+  fill_int(mg->matrix, INF, bytes / sizeof(int));
   return mg;
 }
 
 /* Adauga o muchie intre nodurile sursa si destinatie */
 void mg_add_edge(matrix_graph_t* graph, int src, int dest) {
-  graph->matrix[src][dest] = 1;
+  mg_row(graph, src)[dest] = 1;
 }
 
 /* Returneaza 1 daca exista muchie intre cele doua noduri, 0 in caz contrar */
 int mg_has_edge(matrix_graph_t* graph, int src, int dest) {
-  if (graph->matrix[src][dest] == 1) return 1;
+  if (mg_row(graph, src)[dest] == 1) return 1;
   return 0;
 }
 
 /* Elimina muchia dintre nodurile sursa si destinatie */
 void mg_remove_edge(matrix_graph_t* graph, int src, int dest) {
-  graph->matrix[src][dest] = INF;
+  mg_row(graph, src)[dest] = INF;
 }
 
 /* Elibereaza memoria folosita de matricea de adiacenta a grafului */
 void mg_free(matrix_graph_t* graph) {
-  for (int i = 0; i < graph->nodes; i++) {
-    free(graph->matrix[i]);
-  }
   free(graph->matrix);
   free(graph);
 }
 
-void floydWarshall(matrix_graph_t* mg) {
+static inline int dist_add(int a, int b) { return MIN(a + b, INF); }
+
+/*
+ * Matrice de distante cu elemente inguste (uint8_t sau uint16_t), pentru
+ * cazul in care nicio distanta finita nu ajunge la valoarea maxima a tipului.
+ * Valoarea maxima (UINT8_MAX / UINT16_MAX) tine locul lui INF si se pastreaza
+ * prin adunarea saturata (INF + x = INF). Randurile au aceeasi aliniere ca in
+ * matrix_graph_t, deci intr-un registru SIMD / o linie de cache incap de 2 sau
+ * 4 ori mai multe distante.
+ */
+typedef struct {
+  void* cells;
+  int nodes;
+  int stride;    /* Elemente pe rand, multiplu de ROW_ALIGN / elem_size */
+  int elem_size; /* 1 (uint8_t) sau 2 (uint16_t) */
+} dist_matrix_t;
+
+/*
+ * Un nucleu relaxeaza blocul cu randurile [ib, ie) si coloanele [jb, je)
+ * prin nodurile intermediare [kb, ke): d[i][j] = min(d[i][j], d[i][k] +
+ * d[k][j]). Coloanele pot depasi nodes (pana la stride), completarea fiind
+ * INF.
+ */
+typedef void (*fw_block_fn)(void* cells, int stride, int ib, int ie, int jb,
+                            int je, int kb, int ke);
+
+/* Cum d[i][j] <= INF, minimul satureaza singur suma, fara dist_add. */
+static void fw_block_i32(void* cells, int stride, int ib, int ie, int jb,
+                         int je, int kb, int ke) {
+  int* d = cells;
+
+  for (int k = kb; k < ke; k++) {
+    int* row_k = d + (size_t)k * stride;
+    for (int i = ib; i < ie; i++) {
+      int* row_i = d + (size_t)i * stride;
+      int d_ik = row_i[k];
+      int j = jb;
+
+      if (d_ik >= INF) continue;
+#ifdef __AVX2__
+      __m256i v_ik = _mm256_set1_epi32(d_ik);
+      for (; j + 8 <= je; j += 8) {
+        __m256i via_k = _mm256_add_epi32(
+            v_ik, _mm256_load_si256((__m256i*)(row_k + j)));
+        __m256i cur = _mm256_load_si256((__m256i*)(row_i + j));
+        _mm256_store_si256((__m256i*)(row_i + j), _mm256_min_epi32(cur, via_k));
+      }
+#endif
+      for (; j < je; j++) row_i[j] = MIN(row_i[j], d_ik + row_k[j]);
+    }
+  }
+}
+
+/* 16 distante pe registru; adunarea saturata tine INF pe UINT16_MAX. */
+static void fw_block_u16(void* cells, int stride, int ib, int ie, int jb,
+                         int je, int kb, int ke) {
+  uint16_t* d = cells;
+
+  for (int k = kb; k < ke; k++) {
+    uint16_t* row_k = d + (size_t)k * stride;
+    for (int i = ib; i < ie; i++) {
+      uint16_t* row_i = d + (size_t)i * stride;
+      uint16_t d_ik = row_i[k];
+      int j = jb;
+
+      if (d_ik == UINT16_MAX) continue;
+#ifdef __AVX2__
+      __m256i v_ik = _mm256_set1_epi16((short)d_ik);
+      for (; j + 16 <= je; j += 16) {
+        __m256i via_k = _mm256_adds_epu16(
+            v_ik, _mm256_load_si256((__m256i*)(row_k + j)));
+        __m256i cur = _mm256_load_si256((__m256i*)(row_i + j));
+        _mm256_store_si256((__m256i*)(row_i + j), _mm256_min_epu16(cur, via_k));
+      }
+#endif
+      /* O suma peste UINT16_MAX e oricum mai mare decat row_i[j]. */
+      for (; j < je; j++) {
+        unsigned int via_k = d_ik + row_k[j];
+        if (via_k < row_i[j]) row_i[j] = via_k;
+      }
+    }
+  }
+}
+
+/* 32 distante pe registru; adunarea saturata tine INF pe UINT8_MAX. */
+static void fw_block_u8(void* cells, int stride, int ib, int ie, int jb,
+                        int je, int kb, int ke) {
+  uint8_t* d = cells;
+
+  for (int k = kb; k < ke; k++) {
+    uint8_t* row_k = d + (size_t)k * stride;
+    for (int i = ib; i < ie; i++) {
+      uint8_t* row_i = d + (size_t)i * stride;
+      uint8_t d_ik = row_i[k];
+      int j = jb;
+
+      if (d_ik == UINT8_MAX) continue;
+#ifdef __AVX2__
+      __m256i v_ik = _mm256_set1_epi8((char)d_ik);
+      for (; j + 32 <= je; j += 32) {
+        __m256i via_k = _mm256_adds_epu8(
+            v_ik, _mm256_load_si256((__m256i*)(row_k + j)));
+        __m256i cur = _mm256_load_si256((__m256i*)(row_i + j));
+        _mm256_store_si256((__m256i*)(row_i + j), _mm256_min_epu8(cur, via_k));
+      }
+#endif
+      for (; j < je; j++) {
+        unsigned int via_k = d_ik + row_k[j];
+        if (via_k < row_i[j]) row_i[j] = via_k;
+      }
+    }
+  }
+}
+
+typedef struct {
+  void* cells;
+  int nodes;
+  int stride;
+  fw_block_fn block;
+  pthread_barrier_t barrier;
+  int nthreads;
+} fw_ctx_t;
+
+typedef struct {
+  fw_ctx_t* ctx;
+  int id;
+} fw_arg_t;
+
+/*
+ * Sfarsitul (exclusiv) al blocului de coloane care incepe la j0. Ultimul bloc
+ * se intinde pana la stride, ca latimea sa ramana multiplu de latimea SIMD.
+ */
+static inline int fw_col_end(fw_ctx_t* ctx, int j0) {
+  return MIN(j0 + FW_BLOCK, ctx->stride);
+}
+
+/*
+ * Floyd-Warshall pe blocuri de FW_BLOCK x FW_BLOCK, executat de thread-ul id.
+ * Pentru fiecare bloc de noduri intermediare K:
+ *  1. blocul diagonal (K, K), care depinde doar de el insusi;
+ *  2. blocurile de pe randul K si de pe coloana K, care depind de (K, K);
+ *  3. restul blocurilor (I, J), care depind de (I, K) si (K, J).
+ * Blocurile din aceeasi faza sunt independente si se impart intre thread-uri;
+ * intre faze se asteapta la bariera.
+ */
+static void fw_run(fw_ctx_t* ctx, int id) {
+  int n = ctx->nodes, stride = ctx->stride;
+  int nb = (n + FW_BLOCK - 1) / FW_BLOCK;
+  void* d = ctx->cells;
+
+  for (int kb = 0; kb < nb; kb++) {
+    int k0 = kb * FW_BLOCK, k1 = MIN(k0 + FW_BLOCK, n);
+
+    if (id == 0)
+      ctx->block(d, stride, k0, k1, k0, fw_col_end(ctx, k0), k0, k1);
+    pthread_barrier_wait(&ctx->barrier);
+
+    for (int t = id; t < 2 * nb; t += ctx->nthreads) {
+      int b = t % nb, b0 = b * FW_BLOCK;
+      if (b == kb) continue;
+      if (t < nb)
+        ctx->block(d, stride, k0, k1, b0, fw_col_end(ctx, b0), k0, k1);
+      else
+        ctx->block(d, stride, b0, MIN(b0 + FW_BLOCK, n), k0,
+                   fw_col_end(ctx, k0), k0, k1);
+    }
+    pthread_barrier_wait(&ctx->barrier);
+
+    for (int t = id; t < nb * nb; t += ctx->nthreads) {
+      int ib = t / nb, jb = t % nb;
+      int i0 = ib * FW_BLOCK, j0 = jb * FW_BLOCK;
+      if (ib == kb || jb == kb) continue;
+      ctx->block(d, stride, i0, MIN(i0 + FW_BLOCK, n), j0,
+                 fw_col_end(ctx, j0), k0, k1);
+    }
+    pthread_barrier_wait(&ctx->barrier);
+  }
+}
+
+static void* fw_worker(void* arg) {
+  fw_arg_t* a = arg;
+  fw_run(a->ctx, a->id);
+  return NULL;
+}
+
+/* Ruleaza fw_run pe cel mult nthreads thread-uri (inclusiv cel curent). */
+static void fw_solve_cells(void* cells, int nodes, int stride,
+                           fw_block_fn block, int nthreads) {
+  fw_ctx_t ctx;
+  pthread_t threads[FW_MAX_THREADS];
+  fw_arg_t args[FW_MAX_THREADS];
+  int nb = (nodes + FW_BLOCK - 1) / FW_BLOCK;
+
+  if (nthreads > nb * nb) nthreads = nb * nb;
+  if (nthreads > FW_MAX_THREADS) nthreads = FW_MAX_THREADS;
+  if (nthreads < 1) nthreads = 1;
+
+  ctx.cells = cells;
+  ctx.nodes = nodes;
+  ctx.stride = stride;
+  ctx.block = block;
+  ctx.nthreads = nthreads;
+  pthread_barrier_init(&ctx.barrier, NULL, nthreads);
+
+  for (int t = 1; t < nthreads; t++) {
+    args[t].ctx = &ctx;
+    args[t].id = t;
+    pthread_create(&threads[t], NULL, fw_worker, &args[t]);
+  }
+  fw_run(&ctx, 0);
+  for (int t = 1; t < nthreads; t++) pthread_join(threads[t], NULL);
+
+  pthread_barrier_destroy(&ctx.barrier);
+}
+
+/*
+ * Inlocuieste matricea de adiacenta cu matricea distantelor minime, folosind
+ * cel mult nthreads thread-uri (inclusiv cel curent).
+ */
+void fw_solve(matrix_graph_t* mg, int nthreads) {
+  fw_solve_cells(mg->matrix, mg->nodes, mg->stride, fw_block_i32, nthreads);
+}
+
+/* Ca fw_solve, pentru o matrice de distante cu elemente inguste. */
+void fw_solve_narrow(dist_matrix_t* dm, int nthreads) {
+  fw_solve_cells(dm->cells, dm->nodes, dm->stride,
+                 dm->elem_size == 1 ? fw_block_u8 : fw_block_u16, nthreads);
+}
+
+/*
+ * Copiaza matricea grafului intr-o matrice de distante cu elemente de
+ * elem_size (1 sau 2) octeti. Valorile finite trebuie sa fie mai mici decat
+ * maximul tipului (vezi fw_pick_elem_size). Intoarce NULL daca nu exista
+ * destula memorie.
+ */
+dist_matrix_t* dist_matrix_from_graph(matrix_graph_t* mg, int elem_size) {
+  dist_matrix_t* dm = malloc(sizeof(*dm));
+  size_t bytes;
+
+  if (!dm) return NULL;
+  dm->nodes = mg->nodes;
+  dm->elem_size = elem_size;
+  dm->cells =
+      alloc_rows(mg->nodes, mg->nodes, elem_size, &dm->stride, &bytes);
+  if (!dm->cells) {
+    free(dm);
+    return NULL;
+  }
+  /* Toti octetii 0xFF: UINT8_MAX, respectiv UINT16_MAX, adica INF. */
+  memset(dm->cells, 0xFF, bytes);
+
+  for (int i = 0; i < mg->nodes; i++) {
+    int* row_i = mg_row(mg, i);
+    for (int j = 0; j < mg->nodes; j++) {
+      if (row_i[j] >= INF) continue;
+      if (elem_size == 1)
+        ((uint8_t*)dm->cells)[(size_t)i * dm->stride + j] = row_i[j];
+      else
+        ((uint16_t*)dm->cells)[(size_t)i * dm->stride + j] = row_i[j];
+    }
+  }
+  return dm;
+}
+
+/* Distanta de la i la j, cu INF pentru noduri neconectate */
+static inline int dist_matrix_get(dist_matrix_t* dm, int i, int j) {
+  size_t idx = (size_t)i * dm->stride + j;
+
+  if (dm->elem_size == 1) {
+    uint8_t v = ((uint8_t*)dm->cells)[idx];
+    return v == UINT8_MAX ? INF : v;
+  }
+  uint16_t v = ((uint16_t*)dm->cells)[idx];
+  return v == UINT16_MAX ? INF : v;
+}
+
+/* Scrie distantele din dm inapoi in matricea grafului */
+void dist_matrix_to_graph(dist_matrix_t* dm, matrix_graph_t* mg) {
+  for (int i = 0; i < mg->nodes; i++) {
+    int* row_i = mg_row(mg, i);
+    for (int j = 0; j < mg->nodes; j++) row_i[j] = dist_matrix_get(dm, i, j);
+  }
+}
+
+void dist_matrix_free(dist_matrix_t* dm) {
+  free(dm->cells);
+  free(dm);
+}
+
+/*
+ * Alege cel mai ingust tip (1, 2 sau sizeof(int) octeti) in care incap toate
+ * distantele finite. Un drum minim are cel mult nodes muchii (un ciclu, pe
+ * diagonala), deci nicio distanta nu depaseste nodes * ponderea maxima.
+ */
+int fw_pick_elem_size(matrix_graph_t* mg) {
+  long max_weight = 0, bound;
+
+  for (int i = 0; i < mg->nodes; i++) {
+    int* row_i = mg_row(mg, i);
+    for (int j = 0; j < mg->nodes; j++)
+      if (row_i[j] < INF && row_i[j] > max_weight) max_weight = row_i[j];
+  }
+
+  bound = max_weight * mg->nodes;
+  if (bound < UINT8_MAX) return 1;
+  if (bound < UINT16_MAX) return 2;
+  return sizeof(int);
+}
+
+static int fw_default_threads(void) {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n < 1 ? 1 : (int)MIN(n, FW_MAX_THREADS);
+}
+
+/*
+ * Inlocuieste matricea grafului cu distantele minime, pe cel mai ingust tip
+ * in care acestea incap.
+ */
+void fw_solve_auto(matrix_graph_t* mg, int nthreads) {
+  int elem_size = fw_pick_elem_size(mg);
+
+  if (elem_size == sizeof(int)) {
+    fw_solve(mg, nthreads);
+  } else {
+    dist_matrix_t* dm = dist_matrix_from_graph(mg, elem_size);
+    /* Fara memorie pentru copie, se lucreaza direct pe int. */
+    if (!dm) {
+      fw_solve(mg, nthreads);
+      return;
+    }
+    fw_solve_narrow(dm, nthreads);
+    dist_matrix_to_graph(dm, mg);
+    dist_matrix_free(dm);
+  }
+}
+
+/*
+ * Graf in format CSR (Compressed Sparse Row): vecinii nodului i sunt
+ * targets[offsets[i]], ..., targets[offsets[i + 1] - 1], toti intr-un singur
+ * vector, deci parcurgerea vecinilor este o citire secventiala.
+ */
+typedef struct {
+  int nodes;
+  int edges;
+  int* offsets; /* nodes + 1 elemente */
+  int* targets;
+} csr_graph_t;
+
+/*
+ * Construieste graful CSR echivalent cu mg, in doua treceri: prima numara
+ * muchiile fiecarui nod, a doua copiaza vecinii.
+ */
+csr_graph_t* csr_from_matrix_graph(matrix_graph_t* mg) {
+  csr_graph_t* graph = malloc(sizeof(*graph));
+  graph->nodes = mg->nodes;
+  graph->offsets = malloc((mg->nodes + 1) * sizeof(int));
+  graph->offsets[0] = 0;
+  for (int i = 0; i < mg->nodes; i++) {
+    int* row_i = mg_row(mg, i), degree = 0;
+    for (int j = 0; j < mg->nodes; j++) degree += row_i[j] < INF;
+    graph->offsets[i + 1] = graph->offsets[i] + degree;
+  }
+  graph->edges = graph->offsets[mg->nodes];
+
+  graph->targets = malloc((graph->edges + 1) * sizeof(int));
+  for (int i = 0; i < mg->nodes; i++) {
+    int* row_i = mg_row(mg, i), pos = graph->offsets[i];
+    for (int j = 0; j < mg->nodes; j++)
+      if (row_i[j] < INF) graph->targets[pos++] = j;
+  }
+  return graph;
+}
+
+/* Elibereaza memoria folosita de graful CSR */
+void csr_free(csr_graph_t* graph) {
+  if (!graph) return;
+
+  free(graph->offsets);
+  free(graph->targets);
+  free(graph);
+}
+
+/* Returneaza 1 daca toate muchiile au ponderea 1 (graf neponderat) */
+int mg_is_unweighted(matrix_graph_t* mg) {
+  for (int i = 0; i < mg->nodes; i++) {
+    int* row_i = mg_row(mg, i);
+    for (int j = 0; j < mg->nodes; j++)
+      if (row_i[j] != 1 && row_i[j] < INF) return 0;
+  }
+  return 1;
+}
+
+/* Numarul de surse parcurse simultan: cate una pe fiecare bit din uint64_t */
+#define MSBFS_WIDTH 64
+
+typedef struct {
+  csr_graph_t* csr;
+  matrix_graph_t* mg; /* Primeste distantele */
+  int nthreads;
+  int id;
+} msbfs_arg_t;
+
+/*
+ * BFS din mai multe surse deodata (multi-source BFS): sursa b din lotul
+ * curent foloseste bitul b, iar seen[v], frontier[v] si next[v] spun pentru
+ * care surse a fost atins v, respectiv e pe nivelul curent / urmator. O
+ * muchie v -> u se parcurge o singura data pentru tot lotul: next[u] |=
+ * frontier[v]. Thread-ul id ia loturile id, id + nthreads, ...
+ *
+ * Sursa nu e marcata la inceput, ca sa iasa aceeasi diagonala ca la
+ * Floyd-Warshall: dist[s][s] este lungimea celui mai scurt ciclu prin s.
+ */
+static void* msbfs_worker(void* arg) {
+  msbfs_arg_t* a = arg;
+  csr_graph_t* g = a->csr;
+  int n = g->nodes;
+  int batches = (n + MSBFS_WIDTH - 1) / MSBFS_WIDTH;
+  uint64_t* seen = malloc((n ? n : 1) * sizeof(uint64_t));
+  uint64_t* frontier = malloc((n ? n : 1) * sizeof(uint64_t));
+  uint64_t* next = malloc((n ? n : 1) * sizeof(uint64_t));
+
+  for (int batch = a->id; batch < batches; batch += a->nthreads) {
+    int first = batch * MSBFS_WIDTH;
+    int count = MIN(MSBFS_WIDTH, n - first);
+    int active = 1;
+
+    memset(seen, 0, n * sizeof(uint64_t));
+    memset(frontier, 0, n * sizeof(uint64_t));
+    memset(next, 0, n * sizeof(uint64_t));
+    for (int b = 0; b < count; b++) {
+      frontier[first + b] |= (uint64_t)1 << b;
+      fill_int(mg_row(a->mg, first + b), INF, a->mg->stride);
+    }
+
+    for (int level = 1; active; level++) {
+      for (int v = 0; v < n; v++) {
+        if (!frontier[v]) continue;
+        for (int e = g->offsets[v]; e < g->offsets[v + 1]; e++)
+          next[g->targets[e]] |= frontier[v];
+      }
+
+      active = 0;
+      for (int u = 0; u < n; u++) {
+        uint64_t fresh = next[u] & ~seen[u];
+
+        next[u] = 0;
+        frontier[u] = fresh;
+        if (!fresh) continue;
+        seen[u] |= fresh;
+        active = 1;
+        for (; fresh; fresh &= fresh - 1)
+          mg_row(a->mg, first + __builtin_ctzll(fresh))[u] = level;
+      }
+    }
+  }
+
+  free(seen);
+  free(frontier);
+  free(next);
+  return NULL;
+}
+
+/*
+ * Distante minime pentru un graf neponderat: inlocuieste matricea lui mg cu
+ * distantele, ca fw_solve, dar cu cate un BFS pe bit din fiecare sursa, in
+ * O(V * E / 64) in loc de O(V^3). Loturile de surse se impart intre cel mult
+ * nthreads thread-uri (inclusiv cel curent).
+ */
+void apsp_bfs(matrix_graph_t* mg, int nthreads) {
+  csr_graph_t* csr = csr_from_matrix_graph(mg);
+  pthread_t threads[FW_MAX_THREADS];
+  msbfs_arg_t args[FW_MAX_THREADS];
+  int batches = (mg->nodes + MSBFS_WIDTH - 1) / MSBFS_WIDTH;
+
+  if (nthreads > batches) nthreads = batches;
+  if (nthreads > FW_MAX_THREADS) nthreads = FW_MAX_THREADS;
+  if (nthreads < 1) nthreads = 1;
+  for (int t = 0; t < nthreads; t++) {
+    args[t] = (msbfs_arg_t){csr, mg, nthreads, t};
+    if (t > 0) pthread_create(&threads[t], NULL, msbfs_worker, &args[t]);
+  }
+  msbfs_worker(&args[0]);
+  for (int t = 1; t < nthreads; t++) pthread_join(threads[t], NULL);
+
+  csr_free(csr);
+}
+
+/*
+ * Inlocuieste matricea grafului cu distantele minime: prin BFS daca graful
+ * e neponderat, altfel prin Floyd-Warshall pe cel mai ingust tip posibil.
+ */
+void apsp_solve(matrix_graph_t* mg, int nthreads) {
+  if (mg_is_unweighted(mg))
+    apsp_bfs(mg, nthreads);
+  else
+    fw_solve_auto(mg, nthreads);
+}
+
+/*
+ * Matricea "urmatorului nod": hop[i][j] este vecinul lui i cu care incepe un
+ * drum minim de la i la j. Elementele sunt uint16_t cat timp nodurile incap
+ * (altfel uint32_t), iar valoarea maxima a tipului inseamna "fara drum".
+ */
+typedef struct {
+  void* cells;
+  int nodes;
+  int stride;    /* Elemente pe rand, multiplu de ROW_ALIGN / elem_size */
+  int elem_size; /* 2 (uint16_t) sau 4 (uint32_t) */
+} next_hop_t;
+
+/* Intoarce NULL daca nu exista destula memorie */
+next_hop_t* nh_create(int nodes) {
+  next_hop_t* nh = malloc(sizeof(*nh));
+  size_t bytes;
+
+  if (!nh) return NULL;
+  nh->nodes = nodes;
+  nh->elem_size = nodes < UINT16_MAX ? 2 : 4;
+  nh->cells = alloc_rows(nodes, nodes, nh->elem_size, &nh->stride, &bytes);
+  if (!nh->cells) {
+    free(nh);
+    return NULL;
+  }
+  memset(nh->cells, 0xFF, bytes);
+  return nh;
+}
+
+/* Urmatorul nod pe drumul minim de la i la j, sau -1 daca nu exista drum */
+static inline int nh_get(next_hop_t* nh, int i, int j) {
+  size_t idx = (size_t)i * nh->stride + j;
+
+  if (nh->elem_size == 2) {
+    uint16_t v = ((uint16_t*)nh->cells)[idx];
+    return v == UINT16_MAX ? -1 : v;
+  }
+  uint32_t v = ((uint32_t*)nh->cells)[idx];
+  return v == UINT32_MAX ? -1 : (int)v;
+}
+
+/* hop = -1 se scrie ca maximul tipului, adica "fara drum" */
+static inline void nh_set(next_hop_t* nh, int i, int j, int hop) {
+  size_t idx = (size_t)i * nh->stride + j;
+
+  if (nh->elem_size == 2)
+    ((uint16_t*)nh->cells)[idx] = (uint16_t)hop;
+  else
+    ((uint32_t*)nh->cells)[idx] = (uint32_t)hop;
+}
+
+void nh_free(next_hop_t* nh) {
+  free(nh->cells);
+  free(nh);
+}
+
+typedef struct {
+  matrix_graph_t* adj;  /* Ponderile muchiilor */
+  matrix_graph_t* dist; /* Distantele minime calculate din adj */
+  next_hop_t* nh;
+  int nthreads;
+  int id;
+} nh_arg_t;
+
+/*
+ * Completeaza randurile id, id + nthreads, ... din matricea next hop. Cu
+ * ponderi pozitive, vecinul v al lui i incepe un drum minim spre j exact
+ * cand w(i, v) + dist[v][j] == dist[i][j] (sau v == j si w(i, j) ==
+ * dist[i][j]), iar dist[v][j] < dist[i][j], deci drumurile nu au cicluri.
+ */
+static void* nh_worker(void* arg) {
+  nh_arg_t* a = arg;
+  int n = a->adj->nodes;
+  int* hop = malloc((n ? n : 1) * sizeof(int));
+
+  for (int i = a->id; i < n; i += a->nthreads) {
+    int* adj_i = mg_row(a->adj, i);
+    int* dist_i = mg_row(a->dist, i);
+
+    for (int j = 0; j < n; j++) hop[j] = -1;
+    for (int v = 0; v < n; v++) {
+      int w = adj_i[v];
+      int* dist_v = mg_row(a->dist, v);
+
+      if (w >= INF) continue;
+      if (hop[v] < 0 && w == dist_i[v]) hop[v] = v;
+      for (int j = 0; j < n; j++)
+        if (hop[j] < 0 && dist_i[j] < INF && dist_v[j] + w == dist_i[j])
+          hop[j] = v;
+    }
+    for (int j = 0; j < n; j++) nh_set(a->nh, i, j, hop[j]);
+  }
+
+  free(hop);
+  return NULL;
+}
+
+/*
+ * Calculeaza distantele minime si matricea next hop pentru graful mg, fara
+ * sa il modifice. Daca dist nu e NULL, primeste matricea distantelor (se
+ * elibereaza cu mg_free). Intoarce NULL daca nu exista destula memorie.
+ */
+next_hop_t* fw_solve_paths(matrix_graph_t* mg, matrix_graph_t** dist,
+                           int nthreads) {
+  matrix_graph_t* d = mg_create(mg->nodes);
+  next_hop_t* nh = nh_create(mg->nodes);
+  pthread_t threads[FW_MAX_THREADS];
+  nh_arg_t args[FW_MAX_THREADS];
+
+  if (!d || !nh) {
+    if (d) mg_free(d);
+    if (nh) nh_free(nh);
+    return NULL;
+  }
+  memcpy(d->matrix, mg->matrix, (size_t)mg->nodes * mg->stride * sizeof(int));
+  apsp_solve(d, nthreads);
+
+  if (nthreads > mg->nodes) nthreads = mg->nodes;
+  if (nthreads > FW_MAX_THREADS) nthreads = FW_MAX_THREADS;
+  if (nthreads < 1) nthreads = 1;
+  for (int t = 0; t < nthreads; t++) {
+    args[t] = (nh_arg_t){mg, d, nh, nthreads, t};
+    if (t > 0) pthread_create(&threads[t], NULL, nh_worker, &args[t]);
+  }
+  nh_worker(&args[0]);
+  for (int t = 1; t < nthreads; t++) pthread_join(threads[t], NULL);
+
+  if (dist)
+    *dist = d;
+  else
+    mg_free(d);
+  return nh;
+}
+
+/*
+ * Scrie in path (cu loc pentru nodes elemente) nodurile unui drum minim de
+ * la src la dest, inclusiv capetele, in O(lungimea drumului). Intoarce
+ * numarul de noduri, sau 0 daca nu exista drum.
+ */
+int nh_path(next_hop_t* nh, int src, int dest, int* path) {
+  int len = 0;
+
+  if (src < 0 || src >= nh->nodes || dest < 0 || dest >= nh->nodes) return 0;
+
+  path[len++] = src;
+  while (src != dest) {
+    /* O matrice corupta (ex. citita din fisier) nu trebuie sa cicleze */
+    if (len == nh->nodes) return 0;
+    src = nh_get(nh, src, dest);
+    if (src < 0) return 0;
+    path[len++] = src;
+  }
+  return len;
+}
+
+/*
+ * Formatul fisierului: NH_MAGIC, nodes si elem_size ca int32_t, apoi
+ * randurile, cate nodes elemente, fara completare. Octetii sunt in ordinea
+ * masinii, deci fisierul se citeste doar pe aceeasi arhitectura.
+ */
+#define NH_MAGIC "NHOP"
+
+/* Salveaza matricea in fisierul filename. Intoarce 0 sau -1 la eroare. */
+int nh_save(next_hop_t* nh, const char* filename) {
+  FILE* f = fopen(filename, "wb");
+  int32_t header[2] = {nh->nodes, nh->elem_size};
+  int ok;
+
+  if (!f) return -1;
+  ok = fwrite(NH_MAGIC, 1, 4, f) == 4 && fwrite(header, sizeof(header), 1, f);
+  for (int i = 0; ok && i < nh->nodes; i++) {
+    char* row = (char*)nh->cells + (size_t)i * nh->stride * nh->elem_size;
+    ok = fwrite(row, nh->elem_size, nh->nodes, f) == (size_t)nh->nodes;
+  }
+  if (fclose(f) != 0) ok = 0;
+  return ok ? 0 : -1;
+}
+
+/*
+ * Returneaza 1 daca antetul (nodes, elem_size) este cel pe care l-ar fi scris
+ * nh_save si daca de la pozitia curenta pana la finalul fisierului sunt exact
+ * nodes * nodes elemente. Se verifica inainte de orice alocare, ca un fisier
+ * trunchiat sau corupt sa nu ceara o matrice imposibila.
+ */
+static int nh_header_valid(FILE* f, const int32_t header[2]) {
+  long start, end;
+  unsigned long payload;
+
+  if (header[0] < 0 || header[1] != (header[0] < UINT16_MAX ? 2 : 4))
+    return 0;
+  if ((start = ftell(f)) < 0 || fseek(f, 0, SEEK_END) != 0 ||
+      (end = ftell(f)) < 0 || fseek(f, start, SEEK_SET) != 0)
+    return 0;
+
+  payload = (unsigned long)(end - start);
+  if (header[0] == 0) return payload == 0;
+  if (payload % header[1] != 0) return 0;
+  payload /= header[1];
+  return payload % header[0] == 0 &&
+         payload / header[0] == (unsigned long)header[0];
+}
+
+/* Citeste o matrice salvata cu nh_save. Intoarce NULL la eroare. */
+next_hop_t* nh_load(const char* filename) {
+  FILE* f = fopen(filename, "rb");
+  char magic[4];
+  int32_t header[2];
+  next_hop_t* nh;
+  int ok = 1;
+
+  if (!f) return NULL;
+  if (fread(magic, 1, 4, f) != 4 || memcmp(magic, NH_MAGIC, 4) != 0 ||
+      fread(header, sizeof(header), 1, f) != 1 ||
+      !nh_header_valid(f, header) || !(nh = nh_create(header[0]))) {
+    fclose(f);
+    return NULL;
+  }
+
+  for (int i = 0; ok && i < nh->nodes; i++) {
+    char* row = (char*)nh->cells + (size_t)i * nh->stride * nh->elem_size;
+    ok = fread(row, nh->elem_size, nh->nodes, f) == (size_t)nh->nodes;
+    for (int j = 0; ok && j < nh->nodes; j++)
+      ok = nh_get(nh, i, j) < nh->nodes;
+  }
+  fclose(f);
+
+  if (!ok) {
+    nh_free(nh);
+    return NULL;
+  }
+  return nh;
+}
+
+/*
+ * Bucla clasica, fara blocuri, SIMD sau thread-uri; folosita doar de bench
+ * ca referinta.
+ */
+static void fw_reference(matrix_graph_t* mg) {
   for (int k = 0; k < mg->nodes; k++) {
+    int* row_k = mg_row(mg, k);
     for (int i = 0; i < mg->nodes; i++) {
-      for (int j = 0; j < mg->nodes; j++) {
-        if (mg->matrix[i][k] + mg->matrix[k][j] < mg->matrix[i][j]) {
-          mg->matrix[i][j] = mg->matrix[i][k] + mg->matrix[k][j];
-        }
+      int* row_i = mg_row(mg, i);
+      for (int j = 0; j < mg->nodes; j++)
+        row_i[j] = MIN(row_i[j], dist_add(row_i[k], row_k[j]));
+    }
+  }
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Umple mg cu ~8n muchii aleatoare, aceleasi pentru aceeasi samanta */
+static void bench_graph(matrix_graph_t* mg, unsigned int seed) {
+  int n = mg->nodes;
+
+  srand(seed);
+  for (long e = 0; e < 8L * n; e++) {
+    int src = rand() % n, dest = rand() % n;
+    mg_add_edge(mg, src, dest);
+  }
+}
+
+/* mg_create pentru bench: fara memorie, bench-ul nu poate continua */
+static matrix_graph_t* bench_create(int n) {
+  matrix_graph_t* mg = mg_create(n);
+
+  if (mg == NULL) {
+    printf("Not enough memory for n = %d\n", n);
+    exit(0);
+  }
+  return mg;
+}
+
+/*
+ * Construieste matricea next hop pentru graful de bench si verifica fiecare
+ * drum: capetele, muchiile si lungimea, fata de distantele din ref.
+ */
+static void bench_paths(int n, matrix_graph_t* ref) {
+  matrix_graph_t* mg = bench_create(n);
+  matrix_graph_t* dist;
+  next_hop_t* nh;
+  int* path = malloc((n ? n : 1) * sizeof(int));
+  long hops = 0;
+  int ok = 1;
+  double begin;
+
+  bench_graph(mg, 42);
+  begin = now();
+  nh = fw_solve_paths(mg, &dist, fw_default_threads());
+  if (nh == NULL) {
+    printf("Not enough memory for n = %d\n", n);
+    exit(0);
+  }
+  printf("%-20s %8.3f s  ", "distances + next hop", now() - begin);
+
+  begin = now();
+  for (int i = 0; i < n && ok; i++) {
+    for (int j = 0; j < n && ok; j++) {
+      int len = nh_path(nh, i, j, path), cost = 0;
+
+      if (i == j) {
+        ok = len == 1;
+        continue;
       }
+      ok = mg_row(dist, i)[j] == mg_row(ref, i)[j];
+      if (!ok || len == 0) {
+        ok = ok && mg_row(ref, i)[j] == INF;
+        continue;
+      }
+      for (int p = 0; p + 1 < len; p++)
+        cost = dist_add(cost, mg_row(mg, path[p])[path[p + 1]]);
+      ok = path[0] == i && path[len - 1] == j && cost == mg_row(ref, i)[j];
+      hops += len - 1;
+    }
+  }
+  printf("%ld hops in %.3f s  %s\n", hops, now() - begin,
+         ok ? "ok" : "MISMATCH");
+
+  free(path);
+  nh_free(nh);
+  mg_free(dist);
+  mg_free(mg);
+}
+
+#define BENCH_VARIANTS 6
+
+/*
+ * Compara bucla clasica cu varianta pe blocuri (pe int, pe un thread si pe
+ * toate, apoi pe uint16_t si uint8_t) si cu BFS-ul din mai multe surse pe un
+ * graf aleator cu n noduri si ~8n muchii, apoi verifica drumurile din
+ * matricea next hop. Se ruleaza cu ./1 --bench [n].
+ *
+ * Un tip ingust se masoara doar daca fw_pick_elem_size l-ar alege (pe acest
+ * graf neponderat, uint8_t pentru n < 255 si uint16_t pentru n < 65535).
+ */
+static void bench(int n) {
+  matrix_graph_t* graphs[BENCH_VARIANTS];
+  const char* names[] = {"reference", "int, 1 thread", "int", "uint16_t",
+                         "uint8_t", "multi-source BFS"};
+  double secs[BENCH_VARIANTS];
+
+  for (int g = 0; g < BENCH_VARIANTS; g++) {
+    graphs[g] = bench_create(n);
+    bench_graph(graphs[g], 42);
+  }
+
+  for (int g = 0; g < BENCH_VARIANTS; g++) {
+    dist_matrix_t* dm = NULL;
+    double begin;
+
+    secs[g] = -1;
+    if (g == 3 || g == 4) {
+      int elem_size = g == 3 ? 2 : 1;
+      if (fw_pick_elem_size(graphs[g]) > elem_size) continue;
+      dm = dist_matrix_from_graph(graphs[g], elem_size);
+      if (!dm) continue;
+    }
+    begin = now();
+    if (g == 0)
+      fw_reference(graphs[g]);
+    else if (dm)
+      fw_solve_narrow(dm, fw_default_threads());
+    else if (g == 5)
+      apsp_bfs(graphs[g], fw_default_threads());
+    else
+      fw_solve(graphs[g], g == 1 ? 1 : fw_default_threads());
+    secs[g] = now() - begin;
+
+    if (dm) {
+      dist_matrix_to_graph(dm, graphs[g]);
+      dist_matrix_free(dm);
     }
   }
+
+  for (int g = 0; g < BENCH_VARIANTS; g++) {
+    int same = 1;
+    if (secs[g] < 0) {
+      printf("%-20s skipped: distances may not fit\n", names[g]);
+      continue;
+    }
+    for (int i = 0; i < n && same; i++)
+      same = !memcmp(mg_row(graphs[0], i), mg_row(graphs[g], i),
+                     n * sizeof(int));
+    printf("%-20s %8.3f s  %5.1fx  %s\n", names[g], secs[g],
+           secs[0] / secs[g], same ? "ok" : "MISMATCH");
+  }
+
+  bench_paths(n, graphs[0]);
+  for (int g = 0; g < BENCH_VARIANTS; g++) mg_free(graphs[g]);
+}
+
+/*
+ * Calculeaza distantele minime (in locul matricei de adiacenta) si le
+ * afiseaza. Un graf neponderat se rezolva prin BFS (vezi apsp_solve).
+ */
+void floydWarshall(matrix_graph_t* mg) {
+  apsp_solve(mg, fw_default_threads());
+
   for (int i = 0; i < mg->nodes; i++) {
+    int* row_i = mg_row(mg, i);
     for (int j = 0; j < mg->nodes; j++) {
-      if (mg->matrix[i][j] == INF)
+      if (row_i[j] == INF)
         printf("-1 ");
       else
-        printf("%d ", mg->matrix[i][j]);
+        printf("%d ", row_i[j]);
     }
     printf("\n");
   }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
   matrix_graph_t* mg = NULL;
+  /* Matricea next hop, calculata la "routes" sau citita la "load_routes" */
+  next_hop_t* nh = NULL;
+
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+    bench(argc > 2 ? atoi(argv[2]) : 1024);
+    return 0;
+  }
 
   while (1) {
     char command[MAX_STRING_SIZE];
@@ -92,13 +1060,27 @@ int main() {
 
     if (strncmp(command, "create_mg", 9) == 0) {
       scanf("%d", &nr_nodes);
+      /* Graful nou inlocuieste complet pe cel vechi si rutele lui. */
+      if (nh != NULL) {
+        nh_free(nh);
+        nh = NULL;
+      }
+      if (mg != NULL) mg_free(mg);
       mg = mg_create(nr_nodes);
+      if (mg == NULL) {
+        printf("Could not create the graph!\n");
+        exit(0);
+      }
     }
 
     if (strncmp(command, "add_edge", 8) == 0) {
       if (mg != NULL) {
         scanf("%d %d", &nr1, &nr2);
         mg_add_edge(mg, nr1, nr2);
+        if (nh != NULL) {
+          nh_free(nh);
+          nh = NULL;
+        }
       } else {
         printf("Create a graph first!\n");
         exit(0);
@@ -114,7 +1096,49 @@ int main() {
       }
     }
 
+    if (strncmp(command, "routes", 6) == 0) {
+      if (mg != NULL) {
+        if (nh != NULL) nh_free(nh);
+        nh = fw_solve_paths(mg, NULL, fw_default_threads());
+        if (nh == NULL) printf("Could not compute the routes!\n");
+      } else {
+        printf("Create a graph first!\n");
+        exit(0);
+      }
+    }
+
+    if (strncmp(command, "path", 4) == 0) {
+      scanf("%d %d", &nr1, &nr2);
+      if (nh != NULL) {
+        int* path = malloc((nh->nodes ? nh->nodes : 1) * sizeof(int));
+        int len = nh_path(nh, nr1, nr2, path);
+
+        if (len == 0) printf("No path found");
+        for (int p = 0; p < len; p++) printf("%d ", path[p]);
+        printf("\n");
+        free(path);
+      } else {
+        printf("Compute the routes first!\n");
+      }
+    }
+
+    if (strncmp(command, "save_routes", 11) == 0) {
+      char filename[MAX_STRING_SIZE];
+      scanf("%255s", filename);
+      if (nh == NULL || nh_save(nh, filename) != 0)
+        printf("Could not save the routes!\n");
+    }
+
+    if (strncmp(command, "load_routes", 11) == 0) {
+      char filename[MAX_STRING_SIZE];
+      scanf("%255s", filename);
+      if (nh != NULL) nh_free(nh);
+      nh = nh_load(filename);
+      if (nh == NULL) printf("Could not load the routes!\n");
+    }
+
     if (strncmp(command, "free", 4) == 0) {
+      if (nh != NULL) nh_free(nh);
       if (mg != NULL) {
         mg_free(mg);
       } else {
@@ -1,10 +1,19 @@
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #define MIN(x, y) ((x) < (y) ? (x) : (y))
 #define MAX_STRING_SIZE 256
+#define CACHE_LINE 64
+#define PBFS_MAX_THREADS 64
+/* Cate noduri din frontiera ia un thread odata */
+#define PBFS_CHUNK 64
 
 typedef struct ll_node_t ll_node_t;
 struct ll_node_t {
@@ -153,111 +162,132 @@ void ll_print_string(linked_list_t* list) {
   printf("\n");
 }
 
-typedef struct queue_t queue_t;
-struct queue_t {
-  /* Dimensiunea maxima a cozii */
-  unsigned int max_size;
-  /* Numarul de elemente din coada */
-  unsigned int size;
-  /* Dimensiunea in octeti a tipului de date stocat in coada */
-  unsigned int data_size;
-  /* Indexul de la care se vor efectua operatiile de front si dequeue */
-  unsigned int read_idx;
-  /* Indexul de la care se vor efectua operatiile de dequeue */
-  unsigned int write_idx;
-  /* Bufferul ce stocheaza elementele cozii */
-  void** buff;
-};
-
-queue_t* q_create(unsigned int data_size, unsigned int max_size) {
-  queue_t* q = calloc(1, sizeof(*q));
-
-  q->data_size = data_size;
-  q->max_size = max_size;
-
-  q->buff = malloc(max_size * sizeof(*q->buff));
-
-  return q;
-}
-
-/*
- * Functia intoarce numarul de elemente din coada al carei pointer este trimis
- * ca parametru.
- */
-unsigned int q_get_size(queue_t* q) { return !q ? 0 : q->size; }
-
-/*
- * Intoarce 1 daca coada este goala si 0 in caz contrar.
- */
-unsigned int q_is_empty(queue_t* q) { return !q ? 1 : !q->size; }
-
-/*
- * Functia intoarce primul element din coada, fara sa il elimine.
- */
-void* q_front(queue_t* q) {
-  if (!q || !q->size) return NULL;
-  return q->buff[q->read_idx];
-}
-
-/*
- * Functia scoate un element din coada. Se va intoarce 1 daca operatia s-a
- * efectuat cu succes (exista cel putin un element pentru a fi eliminat) si
- * 0 in caz contrar.
- */
-bool q_dequeue(queue_t* q) {
-  if (!q || !q->size) return false;
-
-  free(q->buff[q->read_idx]);
-
-  q->read_idx = (q->read_idx + 1) % q->max_size;
-  --q->size;
-  return true;
-}
-
-/*
- * Functia introduce un nou element in coada. Se va intoarce 1 daca
- * operatia s-a efectuat cu succes (nu s-a atins dimensiunea maxima)
- * si 0 in caz contrar.
- */
-bool q_enqueue(queue_t* q, void* new_data) {
-  void* data;
-  if (!q || q->size == q->max_size) return false;
-
-  data = malloc(q->data_size);
-  memcpy(data, new_data, q->data_size);
-
-  q->buff[q->write_idx] = data;
-  q->write_idx = (q->write_idx + 1) % q->max_size;
-  ++q->size;
-
-  return true;
-}
-
-/*
- * Functia elimina toate elementele din coada primita ca parametru.
- */
-void q_clear(queue_t* q) {
-  unsigned int i;
-  if (!q || !q->size) return;
-
-  for (i = q->read_idx; i != q->write_idx; i = (i + 1) % q->max_size)
-    free(q->buff[i]);
-
-  q->read_idx = 0;
-  q->write_idx = 0;
-  q->size = 0;
-}
-
 /*
- * Functia elibereaza toata memoria ocupata de coada.
+ * DEFINE_QUEUE(T, name) genereaza o coada circulara specializata pe tipul T:
+ * tipul name##_t si functiile name##_create, name##_get_size, name##_is_empty,
+ * name##_front, name##_dequeue, name##_enqueue, name##_clear si name##_free,
+ * plus variantele pe loturi name##_enqueue_n, name##_dequeue_n si
+ * name##_peek_span. Elementele sunt stocate direct intr-un vector de T (fara
+ * void*), iar toate functiile sunt static inline, deci in BFS operatiile pe
+ * coada devin simple accese in vector.
  */
-void q_free(queue_t* q) {
-  if (!q) return;
+#define DEFINE_QUEUE(T, name)                                                 \
+  typedef struct name##_t {                                                   \
+    T* buff;                                                                  \
+    unsigned int size;                                                        \
+    unsigned int read_idx;                                                    \
+    unsigned int write_idx;                                                   \
+    /* Capacitatea (o putere a lui 2) minus 1 */                              \
+    unsigned int mask;                                                        \
+  } name##_t;                                                                 \
+                                                                              \
+  static inline name##_t* name##_create(unsigned int capacity) {              \
+    name##_t* q = calloc(1, sizeof(*q));                                      \
+    unsigned int pow2 = 1;                                                    \
+                                                                              \
+    while (pow2 < capacity) pow2 <<= 1;                                       \
+    q->mask = pow2 - 1;                                                       \
+    q->buff = malloc((size_t)pow2 * sizeof(T));                               \
+    return q;                                                                 \
+  }                                                                           \
+                                                                              \
+  static inline unsigned int name##_get_size(name##_t* q) { return q->size; } \
+                                                                              \
+  static inline unsigned int name##_is_empty(name##_t* q) {                   \
+    return !q->size;                                                          \
+  }                                                                           \
+                                                                              \
+  /* Primul element; coada nu trebuie sa fie goala. */                        \
+  static inline T name##_front(name##_t* q) { return q->buff[q->read_idx]; }  \
+                                                                              \
+  static inline int name##_dequeue(name##_t* q) {                             \
+    if (!q->size) return 0;                                                   \
+                                                                              \
+    q->read_idx = (q->read_idx + 1) & q->mask;                                \
+    --q->size;                                                                \
+    return 1;                                                                 \
+  }                                                                           \
+                                                                              \
+  /* Dubleaza bufferul, desfacand coada incepand de la pozitia 0. */         \
+  static void name##_grow(name##_t* q) {                                      \
+    unsigned int capacity = q->mask + 1;                                      \
+    T* buff = malloc((size_t)2 * capacity * sizeof(T));                       \
+                                                                              \
+    for (unsigned int i = 0; i < q->size; ++i)                                \
+      buff[i] = q->buff[(q->read_idx + i) & q->mask];                         \
+    free(q->buff);                                                            \
+    q->buff = buff;                                                           \
+    q->read_idx = 0;                                                          \
+    q->write_idx = q->size;                                                   \
+    q->mask = 2 * capacity - 1;                                               \
+  }                                                                           \
+                                                                              \
+  static inline void name##_enqueue(name##_t* q, T value) {                   \
+    if (q->size == q->mask + 1) name##_grow(q);                               \
+                                                                              \
+    q->buff[q->write_idx] = value;                                            \
+    q->write_idx = (q->write_idx + 1) & q->mask;                              \
+    ++q->size;                                                                \
+  }                                                                           \
+                                                                              \
+  /*                                                                          \
+   * Adauga n elemente din src, cu cel mult doua memcpy (inainte si dupa     \
+   * capatul bufferului).                                                    \
+   */                                                                         \
+  static inline void name##_enqueue_n(name##_t* q, const T* src,              \
+                                      unsigned int n) {                       \
+    unsigned int first;                                                       \
+                                                                              \
+    while (q->size + n > q->mask + 1) name##_grow(q);                         \
+    first = MIN(n, q->mask + 1 - q->write_idx);                               \
+    memcpy(q->buff + q->write_idx, src, first * sizeof(T));                   \
+    memcpy(q->buff, src + first, (n - first) * sizeof(T));                    \
+    q->write_idx = (q->write_idx + n) & q->mask;                              \
+    q->size += n;                                                             \
+  }                                                                           \
+                                                                              \
+  /*                                                                          \
+   * Scoate cel mult n elemente si le copiaza in dst (daca dst nu e NULL).    \
+   * Intoarce numarul de elemente scoase.                                     \
+   */                                                                         \
+  static inline unsigned int name##_dequeue_n(name##_t* q, T* dst,            \
+                                              unsigned int n) {               \
+    unsigned int first;                                                       \
+                                                                              \
+    n = MIN(n, q->size);                                                      \
+    if (dst) {                                                                \
+      first = MIN(n, q->mask + 1 - q->read_idx);                              \
+      memcpy(dst, q->buff + q->read_idx, first * sizeof(T));                  \
+      memcpy(dst + first, q->buff, (n - first) * sizeof(T));                  \
+    }                                                                         \
+    q->read_idx = (q->read_idx + n) & q->mask;                                \
+    q->size -= n;                                                             \
+    return n;                                                                 \
+  }                                                                           \
+                                                                              \
+  /*                                                                          \
+   * Zona contigua de la inceputul cozii, fara copiere; *len primeste numarul \
+   * de elemente din ea. Pointerul ramane valid pana la urmatorul enqueue.    \
+   */                                                                         \
+  static inline T* name##_peek_span(name##_t* q, unsigned int* len) {         \
+    *len = MIN(q->size, q->mask + 1 - q->read_idx);                           \
+    return q->buff + q->read_idx;                                             \
+  }                                                                           \
+                                                                              \
+  static inline void name##_clear(name##_t* q) {                              \
+    q->read_idx = 0;                                                          \
+    q->write_idx = 0;                                                         \
+    q->size = 0;                                                              \
+  }                                                                           \
+                                                                              \
+  static inline void name##_free(name##_t* q) {                               \
+    if (!q) return;                                                           \
+                                                                              \
+    free(q->buff);                                                            \
+    free(q);                                                                  \
+  }
 
-  q_clear(q);
-  free(q->buff);
-  free(q);
-}
+DEFINE_QUEUE(int, iq)
 
 /* Graful este ORIENTAT */
 
@@ -318,7 +348,53 @@ void lg_free(list_graph_t* graph) {
   for (int i = 0; i < graph->nodes; i++) {
     ll_free(&graph->neighbors[i]);
   }
-  ll_free(graph->neighbors);
+  free(graph->neighbors);
+  free(graph);
+}
+
+/*
+ * Graf in format CSR (Compressed Sparse Row): vecinii nodului i sunt
+ * targets[offsets[i]], ..., targets[offsets[i + 1] - 1], in aceeasi ordine ca
+ * in lista de adiacenta. Toate listele stau una dupa alta in acelasi vector,
+ * deci parcurgerea vecinilor este o citire secventiala.
+ */
+typedef struct {
+  int nodes;
+  int edges;
+  int* offsets; /* nodes + 1 elemente */
+  int* targets;
+} csr_graph_t;
+
+/*
+ * Construieste graful CSR echivalent cu lg, in doua treceri: prima calculeaza
+ * offseturile din dimensiunile listelor, a doua copiaza vecinii.
+ */
+csr_graph_t* csr_from_list_graph(list_graph_t* lg) {
+  csr_graph_t* graph = malloc(sizeof(*graph));
+  graph->nodes = lg->nodes;
+  graph->offsets = malloc((lg->nodes + 1) * sizeof(int));
+  graph->offsets[0] = 0;
+  for (int i = 0; i < lg->nodes; i++) {
+    graph->offsets[i + 1] = graph->offsets[i] + ll_get_size(lg->neighbors[i]);
+  }
+  graph->edges = graph->offsets[lg->nodes];
+
+  graph->targets = malloc((graph->edges + 1) * sizeof(int));
+  for (int i = 0; i < lg->nodes; i++) {
+    int pos = graph->offsets[i];
+    for (ll_node_t* curr = lg->neighbors[i]->head; curr; curr = curr->next) {
+      graph->targets[pos++] = *(int*)curr->data;
+    }
+  }
+  return graph;
+}
+
+/* Elibereaza memoria folosita de graful CSR */
+void csr_free(csr_graph_t* graph) {
+  if (!graph) return;
+
+  free(graph->offsets);
+  free(graph->targets);
   free(graph);
 }
 
@@ -329,36 +405,432 @@ void lg_free(list_graph_t* graph) {
  * prima data.
  */
 
-void bfs_list_graph(list_graph_t* lg, int node) {
-  int* visited = malloc(lg->nodes * sizeof(int));
-  for (int i = 0; i < lg->nodes; i++) {
-    visited[i] = 0;
-  }
-  queue_t* q = q_create(sizeof(int), lg->nodes);
-  q_enqueue(q, &node);
+/*
+ * Parcurgerea se face pe copia CSR a grafului (csr_from_list_graph), nivel cu
+ * nivel: nodurile nivelului curent se citesc din cur direct din buffer
+ * (iq_peek_span), iar vecinii nou descoperiti se strang in found si se
+ * adauga in next cate BFS_BATCH odata. Ordinea afisarii este cea a BFS-ului
+ * cu o singura coada.
+ */
+#define BFS_BATCH 64
+
+void bfs_csr_graph(csr_graph_t* graph, int node) {
+  int* visited = calloc(graph->nodes, sizeof(int));
+  iq_t* cur = iq_create(graph->nodes);
+  iq_t* next = iq_create(graph->nodes);
+  int found[BFS_BATCH];
+  unsigned int nfound = 0;
+
+  iq_enqueue(cur, node);
   visited[node] = 1;
   printf("%d ", node);
-  while (!q_is_empty(q)) {
-    int current_node = *(int*)q_front(q);
-    q_dequeue(q);
-    linked_list_t* ll = lg->neighbors[current_node];
-    ll_node_t* curr = ll->head;
-    while (curr != NULL) {
-      int neighbor = *(int*)curr->data;
-      if (!visited[neighbor]) {
-        q_enqueue(q, &neighbor);
-        visited[neighbor] = 1;
-        printf("%d ", neighbor);
+  while (!iq_is_empty(cur)) {
+    unsigned int len;
+    int* span = iq_peek_span(cur, &len);
+
+    for (unsigned int i = 0; i < len; i++) {
+      int current_node = span[i];
+      for (int e = graph->offsets[current_node];
+           e < graph->offsets[current_node + 1]; e++) {
+        int neighbor = graph->targets[e];
+        if (!visited[neighbor]) {
+          visited[neighbor] = 1;
+          printf("%d ", neighbor);
+          found[nfound++] = neighbor;
+          if (nfound == BFS_BATCH) {
+            iq_enqueue_n(next, found, nfound);
+            nfound = 0;
+          }
+        }
       }
-      curr = curr->next;
+    }
+    iq_enqueue_n(next, found, nfound);
+    nfound = 0;
+    iq_dequeue_n(cur, NULL, len);
+
+    if (iq_is_empty(cur)) {
+      iq_t* tmp = cur;
+      cur = next;
+      next = tmp;
     }
   }
-  q_free(q);
+  iq_free(cur);
+  iq_free(next);
   free(visited);
 }
 
-int main() {
+/*
+ * Graful transpus: vecinii nodului i sunt nodurile care au muchie spre i, in
+ * ordine crescatoare. Se construieste prin numarare, in O(nodes + edges).
+ */
+csr_graph_t* csr_transpose(csr_graph_t* graph) {
+  csr_graph_t* t = malloc(sizeof(*t));
+  int* pos = calloc(graph->nodes + 1, sizeof(int));
+
+  t->nodes = graph->nodes;
+  t->edges = graph->edges;
+  t->offsets = calloc(graph->nodes + 1, sizeof(int));
+  t->targets = malloc((graph->edges + 1) * sizeof(int));
+
+  for (int e = 0; e < graph->edges; e++) t->offsets[graph->targets[e] + 1]++;
+  for (int i = 0; i < graph->nodes; i++) {
+    t->offsets[i + 1] += t->offsets[i];
+    pos[i] = t->offsets[i];
+  }
+  for (int i = 0; i < graph->nodes; i++) {
+    for (int e = graph->offsets[i]; e < graph->offsets[i + 1]; e++) {
+      t->targets[pos[graph->targets[e]]++] = i;
+    }
+  }
+
+  free(pos);
+  return t;
+}
+
+/*
+ * Pragurile lui Beamer: BFS-ul trece pe bottom-up cand muchiile care pleaca
+ * din frontiera depasesc 1 / DO_ALPHA din muchiile nodurilor nevizitate si
+ * revine la top-down cand frontiera scade sub 1 / DO_BETA din noduri.
+ */
+#define DO_ALPHA 14
+#define DO_BETA 24
+
+static inline int csr_degree(csr_graph_t* graph, int node) {
+  return graph->offsets[node + 1] - graph->offsets[node];
+}
+
+/*
+ * BFS din src care alege la fiecare nivel directia (direction-optimizing):
+ *  - top-down: fiecare nod din frontiera isi parcurge vecinii si ii revendica
+ *    pe cei nevizitati;
+ *  - bottom-up: fiecare nod nevizitat isi cauta, printre muchiile care intra
+ *    in el (graful transpus in), un parinte din frontiera si se opreste la
+ *    primul gasit. Frontiera e tinuta pe biti, ca testul sa fie O(1).
+ * Pe nivelurile din mijloc ale unui graf cu diametru mic aproape toate
+ * nodurile sunt atinse, iar bottom-up se opreste devreme pe fiecare nod.
+ *
+ * La final dist[v] este distanta de la src (sau -1), iar parent[v] un nod de
+ * pe nivelul anterior cu muchie spre v (parent[src] = src, -1 daca v nu e
+ * atins). Distantele sunt aceleasi ca la BFS-ul obisnuit; parintii pot
+ * diferi doar intre candidati egal de buni. Daca in este NULL se face doar
+ * top-down. Intoarce numarul de muchii inspectate.
+ */
+long bfs_direction_optimizing(csr_graph_t* out, csr_graph_t* in, int src,
+                              int* parent, int* dist) {
+  int n = out->nodes, words = (n + 63) / 64;
+  int* front = malloc((n ? n : 1) * sizeof(int));
+  int* next = malloc((n ? n : 1) * sizeof(int));
+  uint64_t* front_bits = malloc((words ? words : 1) * sizeof(uint64_t));
+  long edges_unexplored = out->edges, edges_frontier, checked = 0;
+  int nf = 1, bottom_up = 0;
+
+  for (int i = 0; i < n; i++) {
+    parent[i] = -1;
+    dist[i] = -1;
+  }
+  parent[src] = src;
+  dist[src] = 0;
+  front[0] = src;
+  edges_frontier = csr_degree(out, src);
+  edges_unexplored -= edges_frontier;
+
+  for (int level = 1; nf > 0; level++) {
+    int nn = 0;
+
+    if (in && !bottom_up && edges_frontier > edges_unexplored / DO_ALPHA)
+      bottom_up = 1;
+    else if (bottom_up && nf < n / DO_BETA)
+      bottom_up = 0;
+
+    if (bottom_up) {
+      memset(front_bits, 0, words * sizeof(uint64_t));
+      for (int i = 0; i < nf; i++)
+        front_bits[front[i] / 64] |= (uint64_t)1 << (front[i] % 64);
+
+      for (int v = 0; v < n; v++) {
+        if (dist[v] >= 0) continue;
+        for (int e = in->offsets[v]; e < in->offsets[v + 1]; e++) {
+          int u = in->targets[e];
+          checked++;
+          if ((front_bits[u / 64] >> (u % 64)) & 1) {
+            parent[v] = u;
+            dist[v] = level;
+            next[nn++] = v;
+            break;
+          }
+        }
+      }
+    } else {
+      for (int i = 0; i < nf; i++) {
+        int u = front[i];
+        for (int e = out->offsets[u]; e < out->offsets[u + 1]; e++) {
+          int v = out->targets[e];
+          checked++;
+          if (dist[v] < 0) {
+            parent[v] = u;
+            dist[v] = level;
+            next[nn++] = v;
+          }
+        }
+      }
+    }
+
+    edges_frontier = 0;
+    for (int i = 0; i < nn; i++) edges_frontier += csr_degree(out, next[i]);
+    edges_unexplored -= edges_frontier;
+
+    int* tmp = front;
+    front = next;
+    next = tmp;
+    nf = nn;
+  }
+
+  free(front);
+  free(next);
+  free(front_bits);
+  return checked;
+}
+
+typedef struct pbfs_worker_t pbfs_worker_t;
+
+typedef struct {
+  csr_graph_t* graph;
+  int* parent;
+  int* dist;
+  _Atomic uint64_t* visited; /* Bitul v: v a fost revendicat */
+  int* frontier[2];          /* Nivelul level e in frontier[level % 2] */
+  int next_size;             /* Dimensiunea frontierei urmatoare */
+  atomic_int cursor;         /* Urmatorul nod neluat din frontiera */
+  pbfs_worker_t* workers;
+  int nthreads;
+  pthread_barrier_t barrier;
+} pbfs_ctx_t;
+
+struct pbfs_worker_t {
+  _Alignas(CACHE_LINE) pbfs_ctx_t* ctx;
+  int id;
+  int* local; /* Nodurile gasite de thread pe nivelul curent */
+  int count;
+  int capacity;
+  int offset; /* Unde se copiaza local in frontiera urmatoare */
+};
+
+/*
+ * Revendica nodul v: intoarce 1 doar pentru thread-ul care ii seteaza primul
+ * bitul. Citirea dinainte evita operatia atomica pe nodurile deja vizitate,
+ * care sunt majoritatea.
+ */
+static inline int pbfs_claim(_Atomic uint64_t* visited, int v) {
+  uint64_t mask = (uint64_t)1 << (v % 64);
+
+  if (atomic_load_explicit(&visited[v / 64], memory_order_relaxed) & mask)
+    return 0;
+  return !(atomic_fetch_or_explicit(&visited[v / 64], mask,
+                                    memory_order_relaxed) &
+           mask);
+}
+
+/*
+ * Un nivel are trei pasi separati de bariera:
+ *  1. fiecare thread ia bucati de PBFS_CHUNK noduri din frontiera si pune
+ *     vecinii revendicati in bufferul sau local;
+ *  2. thread-ul 0 calculeaza offseturile bufferelor (suma prefix);
+ *  3. fiecare thread isi copiaza bufferul in frontiera urmatoare.
+ * parent si dist pentru v sunt scrise doar de thread-ul care l-a revendicat.
+ */
+static void* pbfs_worker(void* arg) {
+  pbfs_worker_t* w = arg;
+  pbfs_ctx_t* ctx = w->ctx;
+  csr_graph_t* g = ctx->graph;
+  int size = 1;
+
+  for (int level = 1; size > 0; level++) {
+    int* front = ctx->frontier[(level - 1) % 2];
+    int start;
+
+    w->count = 0;
+    while ((start = atomic_fetch_add_explicit(&ctx->cursor, PBFS_CHUNK,
+                                              memory_order_relaxed)) < size) {
+      int end = MIN(start + PBFS_CHUNK, size);
+      for (int i = start; i < end; i++) {
+        int u = front[i];
+        for (int e = g->offsets[u]; e < g->offsets[u + 1]; e++) {
+          int v = g->targets[e];
+          if (!pbfs_claim(ctx->visited, v)) continue;
+          ctx->parent[v] = u;
+          ctx->dist[v] = level;
+          if (w->count == w->capacity) {
+            w->capacity *= 2;
+            w->local = realloc(w->local, w->capacity * sizeof(int));
+          }
+          w->local[w->count++] = v;
+        }
+      }
+    }
+    pthread_barrier_wait(&ctx->barrier);
+
+    if (w->id == 0) {
+      int offset = 0;
+      for (int t = 0; t < ctx->nthreads; t++) {
+        ctx->workers[t].offset = offset;
+        offset += ctx->workers[t].count;
+      }
+      ctx->next_size = offset;
+      atomic_store_explicit(&ctx->cursor, 0, memory_order_relaxed);
+    }
+    pthread_barrier_wait(&ctx->barrier);
+
+    memcpy(ctx->frontier[level % 2] + w->offset, w->local,
+           w->count * sizeof(int));
+    size = ctx->next_size;
+    pthread_barrier_wait(&ctx->barrier);
+  }
+  return NULL;
+}
+
+/*
+ * BFS paralel, nivel cu nivel, din src, pe cel mult nthreads thread-uri
+ * (inclusiv cel curent). Rezultatul are acelasi sens ca la
+ * bfs_direction_optimizing: dist[v] este distanta de la src (sau -1), iar
+ * parent[v] un nod de pe nivelul anterior cu muchie spre v (parent[src] =
+ * src). Parintii pot diferi de la o rulare la alta intre candidati egal de
+ * buni.
+ */
+void bfs_parallel(csr_graph_t* graph, int src, int* parent, int* dist,
+                  int nthreads) {
+  int n = graph->nodes, words = (n + 63) / 64;
+  pbfs_ctx_t ctx;
+  pbfs_worker_t workers[PBFS_MAX_THREADS];
+  pthread_t threads[PBFS_MAX_THREADS];
+
+  if (nthreads > PBFS_MAX_THREADS) nthreads = PBFS_MAX_THREADS;
+  if (nthreads < 1) nthreads = 1;
+
+  for (int i = 0; i < n; i++) {
+    parent[i] = -1;
+    dist[i] = -1;
+  }
+  parent[src] = src;
+  dist[src] = 0;
+
+  ctx.graph = graph;
+  ctx.parent = parent;
+  ctx.dist = dist;
+  ctx.visited = calloc(words ? words : 1, sizeof(uint64_t));
+  ctx.frontier[0] = malloc((n ? n : 1) * sizeof(int));
+  ctx.frontier[1] = malloc((n ? n : 1) * sizeof(int));
+  ctx.frontier[0][0] = src;
+  atomic_init(&ctx.cursor, 0);
+  ctx.workers = workers;
+  ctx.nthreads = nthreads;
+  pthread_barrier_init(&ctx.barrier, NULL, nthreads);
+  atomic_store(&ctx.visited[src / 64], (uint64_t)1 << (src % 64));
+
+  for (int t = 0; t < nthreads; t++) {
+    workers[t].ctx = &ctx;
+    workers[t].id = t;
+    workers[t].capacity = PBFS_CHUNK;
+    workers[t].local = malloc(PBFS_CHUNK * sizeof(int));
+    if (t > 0) pthread_create(&threads[t], NULL, pbfs_worker, &workers[t]);
+  }
+  pbfs_worker(&workers[0]);
+  for (int t = 1; t < nthreads; t++) pthread_join(threads[t], NULL);
+
+  for (int t = 0; t < nthreads; t++) free(workers[t].local);
+  pthread_barrier_destroy(&ctx.barrier);
+  free(ctx.visited);
+  free(ctx.frontier[0]);
+  free(ctx.frontier[1]);
+}
+
+static int pbfs_default_threads(void) {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n < 1 ? 1 : (int)MIN(n, PBFS_MAX_THREADS);
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Returneaza 1 daca parent / dist formeaza un arbore BFS valid pentru dist */
+static int bfs_tree_valid(csr_graph_t* graph, int src, int* parent, int* dist,
+                          int* ref_dist) {
+  for (int v = 0; v < graph->nodes; v++) {
+    int u = parent[v], found = 0;
+
+    if (dist[v] != ref_dist[v]) return 0;
+    if (dist[v] < 0 || v == src) continue;
+    if (u < 0 || dist[u] != dist[v] - 1) return 0;
+    for (int e = graph->offsets[u]; e < graph->offsets[u + 1] && !found; e++)
+      found = graph->targets[e] == v;
+    if (!found) return 0;
+  }
+  return 1;
+}
+
+/*
+ * Compara BFS-ul top-down cu cel direction-optimizing si cu cel paralel pe
+ * un graf neorientat aleator cu n noduri si ~16n muchii (diametru mic, ca o
+ * retea sociala). Se ruleaza cu ./bfs --bench [n].
+ */
+static void bench(int n) {
+  list_graph_t* lg = lg_create(n);
+  csr_graph_t* out;
+  csr_graph_t* in;
+  int* parent = malloc(n * sizeof(int));
+  int* dist = malloc(n * sizeof(int));
+  int* ref_dist = malloc(n * sizeof(int));
+  long checked_td, checked_do;
+  double t_td, t_do, t_par, begin;
+
+  srand(42);
+  for (long e = 0; e < 8L * n; e++) {
+    int a = rand() % n, b = rand() % n;
+    lg_add_edge(lg, a, b);
+    lg_add_edge(lg, b, a);
+  }
+  out = csr_from_list_graph(lg);
+  in = csr_transpose(out);
+
+  begin = now();
+  checked_td = bfs_direction_optimizing(out, NULL, 0, parent, ref_dist);
+  t_td = now() - begin;
+
+  begin = now();
+  checked_do = bfs_direction_optimizing(out, in, 0, parent, dist);
+  t_do = now() - begin;
+
+  printf("top-down             %10ld edges  %8.4f s\n", checked_td, t_td);
+  printf("direction-optimizing %10ld edges  %8.4f s  %5.1fx fewer  %s\n",
+         checked_do, t_do, (double)checked_td / (checked_do ? checked_do : 1),
+         bfs_tree_valid(out, 0, parent, dist, ref_dist) ? "ok" : "MISMATCH");
+
+  begin = now();
+  bfs_parallel(out, 0, parent, dist, pbfs_default_threads());
+  t_par = now() - begin;
+  printf("parallel, %2d threads %10s        %8.4f s  %5.1fx faster %s\n",
+         pbfs_default_threads(), "", t_par, t_td / t_par,
+         bfs_tree_valid(out, 0, parent, dist, ref_dist) ? "ok" : "MISMATCH");
+
+  free(parent);
+  free(dist);
+  free(ref_dist);
+  csr_free(out);
+  csr_free(in);
+  lg_free(lg);
+}
+
+int main(int argc, char* argv[]) {
   list_graph_t* lg = NULL;
+  /* Copia CSR a lui lg; se reconstruieste doar dupa ce lg se modifica. */
+  csr_graph_t* csr = NULL;
+
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+    bench(argc > 2 ? atoi(argv[2]) : 1 << 17);
+    return 0;
+  }
 
   while (1) {
     char command[MAX_STRING_SIZE];
@@ -370,6 +842,10 @@ int main() {
 
     if (strncmp(command, "create_lg", 9) == 0) {
       scanf("%d", &nr_nodes);
+      /* Graful nou inlocuieste complet pe cel vechi si copia lui CSR. */
+      csr_free(csr);
+      csr = NULL;
+      if (lg != NULL) lg_free(lg);
       lg = lg_create(nr_nodes);
     }
 
@@ -377,6 +853,8 @@ int main() {
       if (lg != NULL) {
         scanf("%d %d", &nr1, &nr2);
         lg_add_edge(lg, nr1, nr2);
+        csr_free(csr);
+        csr = NULL;
       } else {
         printf("Create a graph first!\n");
         exit(0);
@@ -394,7 +872,8 @@ int main() {
       if (lg != NULL) {
         scanf("%d", &start_node);
 
-        bfs_list_graph(lg, start_node);
+        if (!csr) csr = csr_from_list_graph(lg);
+        bfs_csr_graph(csr, start_node);
       } else {
         printf("Create a graph first!\n");
         exit(0);
@@ -403,6 +882,7 @@ int main() {
 
     if (strncmp(command, "free", 4) == 0) {
       if (lg != NULL) {
+        csr_free(csr);
         lg_free(lg);
       } else {
         printf("Create a graph first!\n");
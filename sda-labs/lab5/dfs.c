@@ -275,13 +275,88 @@ void st_free(stack* st) {
   free(st);
 }
 
+/*
+ * DEFINE_STACK(T, name) genereaza o stiva specializata pe tipul T: tipul
+ * name##_t si functiile name##_create, name##_get_size, name##_is_empty,
+ * name##_peek, name##_pop, name##_push, name##_clear si name##_free, cu
+ * aceeasi semantica precum st_* de mai sus. Elementele sunt stocate direct
+ * intr-un vector de T care se dubleaza la nevoie (fara noduri alocate
+ * separat, void* si memcpy), iar toate functiile sunt static inline.
+ */
+#define DEFINE_STACK(T, name)                                                 \
+  typedef struct name##_t {                                                   \
+    T* data;                                                                  \
+    unsigned int size;                                                        \
+    unsigned int capacity;                                                    \
+  } name##_t;                                                                 \
+                                                                              \
+  static inline name##_t* name##_create(unsigned int capacity) {              \
+    name##_t* st = malloc(sizeof(*st));                                       \
+                                                                              \
+    st->size = 0;                                                             \
+    st->capacity = capacity ? capacity : 1;                                   \
+    st->data = malloc((size_t)st->capacity * sizeof(T));                      \
+    return st;                                                                \
+  }                                                                           \
+                                                                              \
+  static inline unsigned int name##_get_size(name##_t* st) {                  \
+    return st->size;                                                          \
+  }                                                                           \
+                                                                              \
+  static inline unsigned int name##_is_empty(name##_t* st) {                  \
+    return !st->size;                                                         \
+  }                                                                           \
+                                                                              \
+  /* Elementul din varf; stiva nu trebuie sa fie goala. */                    \
+  static inline T name##_peek(name##_t* st) {                                 \
+    return st->data[st->size - 1];                                            \
+  }                                                                           \
+                                                                              \
+  static inline void name##_pop(name##_t* st) {                               \
+    if (st->size) --st->size;                                                 \
+  }                                                                           \
+                                                                              \
+  static inline void name##_push(name##_t* st, T value) {                     \
+    if (st->size == st->capacity) {                                           \
+      st->capacity *= 2;                                                      \
+      st->data = realloc(st->data, (size_t)st->capacity * sizeof(T));         \
+    }                                                                         \
+                                                                              \
+    st->data[st->size++] = value;                                             \
+  }                                                                           \
+                                                                              \
+  static inline void name##_clear(name##_t* st) { st->size = 0; }             \
+                                                                              \
+  static inline void name##_free(name##_t* st) {                              \
+    if (!st) return;                                                          \
+                                                                              \
+    free(st->data);                                                           \
+    free(st);                                                                 \
+  }
+
+DEFINE_STACK(int, is)
+
 /* --- START IMPLEMENT MATRIX GRAPH HERE --- */
 
+/* Randurile matricei incep la o linie de cache si au ROW_INTS int-uri */
+#define ROW_ALIGN 64
+#define ROW_INTS (ROW_ALIGN / (int)sizeof(int))
+
+/*
+ * Matricea este stocata rand dupa rand intr-o singura alocare aliniata, cu
+ * stride >= nodes elemente pe rand (multiplu de ROW_INTS).
+ */
 typedef struct {
-  int** matrix; /* Matricea de adiacenta a grafului */
-  int nodes;    /* Numarul de noduri din graf. */
+  int* matrix; /* Matricea de adiacenta a grafului */
+  int nodes;   /* Numarul de noduri din graf. */
+  int stride;  /* Distanta, in elemente, intre inceputurile a doua randuri */
 } matrix_graph_t;
 
+/* Randul nodului node din matricea de adiacenta */
+static inline int* mg_row(matrix_graph_t* graph, int node) {
+  return graph->matrix + (size_t)node * graph->stride;
+}
+
 /**
  * Initializeaza graful cu numarul de noduri primit ca parametru si aloca
  * memorie pentru matricea de adiacenta a grafului.
@@ -291,29 +366,22 @@ typedef struct {
 
 matrix_graph_t* mg_create(int nodes) {
   matrix_graph_t* graph = malloc(sizeof(*graph));
+  size_t bytes;
   graph->nodes = nodes;
-  graph->matrix = malloc(nodes * sizeof(int*));
-  for (int i = 0; i < graph->nodes; i++) {
-    graph->matrix[i] = malloc(nodes * sizeof(int));
-  }
-  for (int i = 0; i < graph->nodes; i++) {
-    for (int j = 0; j < graph->nodes; j++) {
-      graph->matrix[i][j] = 0;
-    }
-  }
+  graph->stride = (nodes + ROW_INTS - 1) / ROW_INTS * ROW_INTS;
+  bytes = (size_t)nodes * graph->stride * sizeof(int);
+  graph->matrix = aligned_alloc(ROW_ALIGN, bytes ? bytes : ROW_ALIGN);
+  memset(graph->matrix, 0, bytes);
   return graph;
 }
 
 /* Adauga o muchie intre nodurile sursa si destinatie */
 void mg_add_edge(matrix_graph_t* graph, int src, int dest) {
-  graph->matrix[src][dest] = 1;
+  mg_row(graph, src)[dest] = 1;
 }
 
 /* Elibereaza memoria folosita de matricea de adiacenta a grafului */
 void mg_free(matrix_graph_t* graph) {
-  for (int i = 0; i < graph->nodes; i++) {
-    free(graph->matrix[i]);
-  }
   free(graph->matrix);
   free(graph);
 }
@@ -331,28 +399,29 @@ void dfs_matrix_graph(matrix_graph_t* mg, int node) {
   for (int i = 0; i < mg->nodes; i++) {
     visited[i] = 0;
   }
-  stack* st = st_create(sizeof(int));
-  st_push(st, &node);
-  while (!st_is_empty(st)) {
-    int current_node = *(int*)st_peek(st);
+  is_t* st = is_create(mg->nodes);
+  is_push(st, node);
+  while (!is_is_empty(st)) {
+    int current_node = is_peek(st);
     if (!visited[current_node]) {
       printf("%d ", current_node);
       visited[current_node] = 1;
     }
     int gasit = 0;
+    int* row = mg_row(mg, current_node);
     for (int i = 0; i < mg->nodes; i++) {
-      if (mg->matrix[current_node][i] == 1 && !visited[i]) {
-        st_push(st, &i);
+      if (row[i] == 1 && !visited[i]) {
+        is_push(st, i);
         gasit = 1;
         break;
       }
     }
     if (!gasit) {
-      st_pop(st);
+      is_pop(st);
     }
   }
   free(visited);
-  st_free(st);
+  is_free(st);
 }
 
 int main() {
@@ -1,11 +1,31 @@
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 #define MAX_STRING_SIZE 256
+#define CACHE_LINE 64
+/* Cate cuvinte de 64 de biti incap intr-o linie de cache */
+#define WORDS_PER_LINE (CACHE_LINE / sizeof(uint64_t))
+#define TC_MAX_THREADS 64
+
+/*
+ * Matricea de adiacenta este pastrata pe biti: bitul j % 64 din cuvantul
+ * j / 64 al randului i este 1 daca exista muchia i -> j. Toate randurile stau
+ * intr-o singura alocare, fiecare incepand la o linie de cache (randurile
+ * sunt completate cu cuvinte nule pana la words_per_row).
+ */
 typedef struct {
-  int** matrix; /* Matricea de adiacenta a grafului */
-  int nodes;    /* Numarul de noduri din graf. */
+  uint64_t* matrix;  /* Matricea de adiacenta a grafului */
+  int nodes;         /* Numarul de noduri din graf. */
+  int words_per_row; /* Cuvinte pe rand, multiplu de WORDS_PER_LINE */
 } matrix_graph_t;
 
 /**
@@ -19,53 +39,253 @@ typedef struct {
 
 matrix_graph_t* mg_create(int nodes) {
   matrix_graph_t* graph = malloc(sizeof(*graph));
+  int words = (nodes + 63) / 64;
+  size_t bytes;
+
   graph->nodes = nodes;
-  graph->matrix = malloc(nodes * sizeof(int*));
-  for (int i = 0; i < graph->nodes; i++) {
-    graph->matrix[i] = malloc(nodes * sizeof(int));
-  }
-  for (int i = 0; i < graph->nodes; i++) {
-    for (int j = 0; j < graph->nodes; j++) {
-      graph->matrix[i][j] = 0;
-    }
-  }
+  graph->words_per_row =
+      (words + WORDS_PER_LINE - 1) / WORDS_PER_LINE * WORDS_PER_LINE;
+  bytes = (size_t)nodes * graph->words_per_row * sizeof(uint64_t);
+  graph->matrix = aligned_alloc(CACHE_LINE, bytes ? bytes : CACHE_LINE);
+  memset(graph->matrix, 0, bytes);
   return graph;
 }
 
+/* Randul nodului node: words_per_row cuvinte, aliniat la linia de cache */
+static inline uint64_t* mg_row(matrix_graph_t* graph, int node) {
+  return graph->matrix + (size_t)node * graph->words_per_row;
+}
+
 /* Adauga o muchie intre nodurile sursa si destinatie */
 void mg_add_edge(matrix_graph_t* graph, int src, int dest) {
-  graph->matrix[src][dest] = 1;
+  mg_row(graph, src)[dest / 64] |= (uint64_t)1 << (dest % 64);
 }
 
 /* Returneaza 1 daca exista muchie intre cele doua noduri, 0 in caz contrar */
 int mg_has_edge(matrix_graph_t* graph, int src, int dest) {
-  if (graph->matrix[src][dest] == 1) return 1;
-  return 0;
+  return (mg_row(graph, src)[dest / 64] >> (dest % 64)) & 1;
 }
 
 /* Elimina muchia dintre nodurile sursa si destinatie */
 void mg_remove_edge(matrix_graph_t* graph, int src, int dest) {
-  graph->matrix[src][dest] = 0;
+  mg_row(graph, src)[dest / 64] &= ~((uint64_t)1 << (dest % 64));
+}
+
+/* Returneaza numarul de vecini ai nodului (numarul de biti setati pe rand) */
+int mg_out_degree(matrix_graph_t* graph, int node) {
+  uint64_t* row = mg_row(graph, node);
+  int degree = 0;
+
+  for (int w = 0; w < graph->words_per_row; w++)
+    degree += __builtin_popcountll(row[w]);
+  return degree;
+}
+
+/*
+ * Randul dest devine dest | src (dest primeste toti vecinii lui src). Cu AVX2
+ * se proceseaza 256 de biti odata; randurile au un numar intreg de linii de
+ * cache, deci nu ramane rest.
+ */
+void mg_row_or(matrix_graph_t* graph, int dest, int src) {
+  uint64_t* d = mg_row(graph, dest);
+  uint64_t* s = mg_row(graph, src);
+  int w = 0;
+
+#ifdef __AVX2__
+  for (; w + 4 <= graph->words_per_row; w += 4) {
+    __m256i v = _mm256_or_si256(_mm256_load_si256((__m256i*)(d + w)),
+                                _mm256_load_si256((__m256i*)(s + w)));
+    _mm256_store_si256((__m256i*)(d + w), v);
+  }
+#endif
+  for (; w < graph->words_per_row; w++) d[w] |= s[w];
+}
+
+/* Randul dest devine dest & src (raman doar vecinii comuni) */
+void mg_row_and(matrix_graph_t* graph, int dest, int src) {
+  uint64_t* d = mg_row(graph, dest);
+  uint64_t* s = mg_row(graph, src);
+
+  for (int w = 0; w < graph->words_per_row; w++) d[w] &= s[w];
+}
+
+/*
+ * Returneaza primul vecin al lui node care este >= from sau -1 daca nu mai
+ * exista. Toti vecinii se obtin in ordine pornind cu from = 0 si apoi cu
+ * from = ultimul vecin + 1. Cuvintele nule se sar intregi, iar in cuvant
+ * bitul se gaseste cu ctz.
+ */
+int mg_next_neighbor(matrix_graph_t* graph, int node, int from) {
+  uint64_t* row = mg_row(graph, node);
+  int w = from / 64;
+  uint64_t word;
+
+  if (from >= graph->nodes) return -1;
+
+  word = row[w] & (~(uint64_t)0 << (from % 64));
+  while (!word) {
+    if (++w == graph->words_per_row) return -1;
+    word = row[w];
+  }
+  return w * 64 + __builtin_ctzll(word);
 }
 
 /* Elibereaza memoria folosita de matricea de adiacenta a grafului */
 void mg_free(matrix_graph_t* graph) {
-  for (int i = 0; i < graph->nodes; i++) free(graph->matrix[i]);
   free(graph->matrix);
   free(graph);
 }
 
+typedef struct {
+  matrix_graph_t* closure;
+  pthread_barrier_t barrier;
+  int nthreads;
+} tc_ctx_t;
+
+typedef struct {
+  tc_ctx_t* ctx;
+  int id;
+} tc_arg_t;
+
+/*
+ * Warshall pe biti, executat de thread-ul id: pentru fiecare k, orice rand i
+ * care il atinge pe k primeste tot ce atinge k (rand i |= rand k). La pasul k
+ * randul k nu se schimba (k |= k), deci randurile i != k sunt independente si
+ * se impart intre thread-uri (id, id + nthreads, ...); intre pasi se asteapta
+ * la bariera.
+ */
+static void* tc_worker(void* arg) {
+  tc_arg_t* a = arg;
+  matrix_graph_t* c = a->ctx->closure;
+
+  for (int k = 0; k < c->nodes; k++) {
+    uint64_t bit = (uint64_t)1 << (k % 64);
+    for (int i = a->id; i < c->nodes; i += a->ctx->nthreads)
+      if (i != k && (mg_row(c, i)[k / 64] & bit)) mg_row_or(c, i, k);
+    if (a->ctx->nthreads > 1) pthread_barrier_wait(&a->ctx->barrier);
+  }
+  return NULL;
+}
+
+/*
+ * Returneaza inchiderea tranzitiva a grafului, ca matrice pe biti: bitul
+ * (i, j) este 1 daca exista un drum nevid de la i la j (deci (i, i) doar daca
+ * i este pe un ciclu). Interogarea este mg_has_edge, in O(1), pe 1 bit pe
+ * pereche in loc de un int. Se folosesc cel mult nthreads thread-uri
+ * (inclusiv cel curent).
+ */
+matrix_graph_t* mg_transitive_closure(matrix_graph_t* mg, int nthreads) {
+  matrix_graph_t* closure = mg_create(mg->nodes);
+  pthread_t threads[TC_MAX_THREADS];
+  tc_arg_t args[TC_MAX_THREADS];
+  tc_ctx_t ctx;
+
+  memcpy(closure->matrix, mg->matrix,
+         (size_t)mg->nodes * mg->words_per_row * sizeof(uint64_t));
+
+  if (nthreads > mg->nodes) nthreads = mg->nodes;
+  if (nthreads > TC_MAX_THREADS) nthreads = TC_MAX_THREADS;
+  if (nthreads < 1) nthreads = 1;
+  ctx.closure = closure;
+  ctx.nthreads = nthreads;
+  pthread_barrier_init(&ctx.barrier, NULL, nthreads);
+
+  for (int t = 0; t < nthreads; t++) {
+    args[t].ctx = &ctx;
+    args[t].id = t;
+    if (t > 0) pthread_create(&threads[t], NULL, tc_worker, &args[t]);
+  }
+  tc_worker(&args[0]);
+  for (int t = 1; t < nthreads; t++) pthread_join(threads[t], NULL);
+
+  pthread_barrier_destroy(&ctx.barrier);
+  return closure;
+}
+
+static int tc_default_threads(void) {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n < 1 ? 1 : (int)(n < TC_MAX_THREADS ? n : TC_MAX_THREADS);
+}
+
+/*
+ * Warshall clasic, bit cu bit, fara randuri intregi sau thread-uri; folosit
+ * doar de bench ca referinta.
+ */
+static matrix_graph_t* tc_reference(matrix_graph_t* mg) {
+  matrix_graph_t* closure = mg_create(mg->nodes);
+
+  for (int i = 0; i < mg->nodes; i++)
+    for (int j = 0; j < mg->nodes; j++)
+      if (mg_has_edge(mg, i, j)) mg_add_edge(closure, i, j);
+
+  for (int k = 0; k < mg->nodes; k++)
+    for (int i = 0; i < mg->nodes; i++) {
+      if (!mg_has_edge(closure, i, k)) continue;
+      for (int j = 0; j < mg->nodes; j++)
+        if (mg_has_edge(closure, k, j)) mg_add_edge(closure, i, j);
+    }
+  return closure;
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Compara Warshall bit cu bit cu varianta pe randuri (pe un thread si pe
+ * toate) pe un graf aleator cu n noduri si ~2n muchii. Se ruleaza cu
+ * ./matrix --bench [n].
+ */
+static void bench(int n) {
+  matrix_graph_t* mg = mg_create(n);
+  matrix_graph_t* closures[3];
+  const char* names[] = {"reference", "rows, 1 thread", "rows"};
+  double secs[3];
+  size_t bytes = (size_t)n * mg->words_per_row * sizeof(uint64_t);
+
+  srand(42);
+  for (int e = 0; e < 2 * n; e++) mg_add_edge(mg, rand() % n, rand() % n);
+
+  for (int v = 0; v < 3; v++) {
+    double begin = now();
+    if (v == 0)
+      closures[v] = tc_reference(mg);
+    else
+      closures[v] =
+          mg_transitive_closure(mg, v == 1 ? 1 : tc_default_threads());
+    secs[v] = now() - begin;
+  }
+
+  for (int v = 0; v < 3; v++) {
+    int same = !memcmp(closures[0]->matrix, closures[v]->matrix, bytes);
+    printf("%-16s %8.3f s  %6.1fx  %s\n", names[v], secs[v], secs[0] / secs[v],
+           same ? "ok" : "MISMATCH");
+  }
+
+  for (int v = 0; v < 3; v++) mg_free(closures[v]);
+  mg_free(mg);
+}
+
 void print_matrix_graph(matrix_graph_t* mg) {
   for (int i = 0; i < mg->nodes; i++) {
     for (int j = 0; j < mg->nodes; j++) {
-      printf("%d ", mg->matrix[i][j]);
+      printf("%d ", mg_has_edge(mg, i, j));
     }
     printf("\n");
   }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
   matrix_graph_t* mg = NULL;
+  /* Inchiderea tranzitiva, calculata la "closure" */
+  matrix_graph_t* closure = NULL;
+
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+    bench(argc > 2 ? atoi(argv[2]) : 1024);
+    return 0;
+  }
 
   while (1) {
     char command[MAX_STRING_SIZE];
@@ -76,6 +296,12 @@ int main() {
 
     if (strncmp(command, "create_mg", 9) == 0) {
       scanf("%d", &nr_nodes);
+      /* Graful nou inlocuieste complet pe cel vechi si inchiderea lui. */
+      if (closure != NULL) {
+        mg_free(closure);
+        closure = NULL;
+      }
+      if (mg != NULL) mg_free(mg);
       mg = mg_create(nr_nodes);
     }
 
@@ -83,6 +309,10 @@ int main() {
       if (mg != NULL) {
         scanf("%d %d", &nr1, &nr2);
         mg_add_edge(mg, nr1, nr2);
+        if (closure != NULL) {
+          mg_free(closure);
+          closure = NULL;
+        }
       } else {
         printf("Create a graph first!\n");
         exit(0);
@@ -93,6 +323,10 @@ int main() {
       if (mg != NULL) {
         scanf("%d %d", &nr1, &nr2);
         mg_remove_edge(mg, nr1, nr2);
+        if (closure != NULL) {
+          mg_free(closure);
+          closure = NULL;
+        }
       } else {
         printf("Create a graph first!\n");
         exit(0);
@@ -124,7 +358,30 @@ int main() {
       }
     }
 
+    if (strncmp(command, "closure", 7) == 0) {
+      if (mg != NULL) {
+        if (closure != NULL) mg_free(closure);
+        closure = mg_transitive_closure(mg, tc_default_threads());
+      } else {
+        printf("Create a graph first!\n");
+        exit(0);
+      }
+    }
+
+    if (strncmp(command, "reachable", 9) == 0) {
+      scanf("%d %d", &nr1, &nr2);
+      if (closure != NULL) {
+        if (mg_has_edge(closure, nr1, nr2))
+          printf("Reachable\n");
+        else
+          printf("Not reachable\n");
+      } else {
+        printf("Compute the closure first!\n");
+      }
+    }
+
     if (strncmp(command, "free", 4) == 0) {
+      if (closure != NULL) mg_free(closure);
       if (mg != NULL) {
         mg_free(mg);
       } else {
@@ -18,47 +18,36 @@
     }                                                    \
   } while (0)
 
-typedef struct ll_node_t ll_node_t;
-typedef struct linked_list_t linked_list_t;
 typedef struct queue_t queue_t;
-typedef struct list_graph_t list_graph_t;
+typedef struct csr_graph_t csr_graph_t;
 
 /* Helper data structures definitions */
-struct ll_node_t {
-  void *data;
-  ll_node_t *next;
-};
-
-struct linked_list_t {
-  ll_node_t *head;
-  unsigned int data_size;
-  unsigned int size;
-};
-
 struct queue_t {
   unsigned int max_size;
   unsigned int size;
   unsigned int data_size;
   unsigned int read_idx;
   unsigned int write_idx;
-  void **buff;
+  unsigned int mask;
+  void *buff;
 };
 
-struct list_graph_t {
-  linked_list_t **neighbors;
+/*
+ * Graf in format CSR (Compressed Sparse Row): vecinii nodului i sunt
+ * targets[offsets[i]], ..., targets[offsets[i + 1] - 1], in ordinea in care
+ * au fost adaugate muchiile. Toate listele de adiacenta stau una dupa alta
+ * in acelasi vector, deci parcurgerea vecinilor este o citire secventiala.
+ */
+struct csr_graph_t {
   int nodes;
+  int edges;
+  /* nodes + 1 elemente */
+  int *offsets;
+  int *targets;
 };
 
-linked_list_t *ll_create(unsigned int data_size);
-static ll_node_t *get_nth_node(linked_list_t *list, unsigned int n);
-void ll_add_nth_node(linked_list_t *list, unsigned int n, const void *new_data);
-ll_node_t *ll_remove_nth_node(linked_list_t *list, unsigned int n);
-unsigned int ll_get_size(linked_list_t *list);
-void ll_free(linked_list_t **pp_list);
-void ll_print_int(linked_list_t *list);
-void ll_print_string(linked_list_t *list);
-
-queue_t *q_create(unsigned int data_size, unsigned int max_size);
+queue_t *q_create(unsigned int data_size, unsigned int capacity);
+void q_set_max_size(queue_t *q, unsigned int max_size);
 unsigned int q_get_size(queue_t *q);
 unsigned int q_is_empty(queue_t *q);
 void *q_front(queue_t *q);
@@ -67,13 +56,8 @@ int q_enqueue(queue_t *q, void *new_data);
 void q_clear(queue_t *q);
 void q_free(queue_t *q);
 
-list_graph_t *lg_create(int nodes);
-void lg_add_edge(list_graph_t *graph, int src, int dest);
-static ll_node_t *find_node(linked_list_t *ll, int node, unsigned int *pos);
-int lg_has_edge(list_graph_t *graph, int src, int dest);
-linked_list_t *lg_get_neighbours(list_graph_t *graph, int node);
-void lg_remove_edge(list_graph_t *graph, int src, int dest);
-void lg_free(list_graph_t *graph);
+csr_graph_t *csr_create(int nodes, const int *edges, int m, int undirected);
+void csr_free(csr_graph_t *graph);
 
 /*
     TODO
@@ -107,7 +91,7 @@ void lg_free(list_graph_t *graph);
     can be either oriented or unoriented. For this exercise, the graph
     is unoriented.
 */
-void print_bipartite(list_graph_t *graph) {
+void print_bipartite(csr_graph_t *graph) {
   int *visited = malloc(graph->nodes * sizeof(int));
   int *color = malloc(graph->nodes * sizeof(int));
   for (int i = 0; i < graph->nodes; i++) {
@@ -122,14 +106,16 @@ void print_bipartite(list_graph_t *graph) {
   while (!q_is_empty(q)) {
     int current_node = *(int *)q_front(q);
     q_dequeue(q);
-    linked_list_t *ll = graph->neighbors[current_node];
-    ll_node_t *curr = ll->head;
-    while (curr != NULL) {
-      int neighbor = *(int *)curr->data;
+    for (int e = graph->offsets[current_node];
+         e < graph->offsets[current_node + 1]; e++) {
+      int neighbor = graph->targets[e];
       if (!visited[neighbor]) {
         q_enqueue(q, &neighbor);
         if (color[current_node] == color[neighbor] && color[neighbor] != 0) {
           printf("Graph is not bipartite");
+          q_free(q);
+          free(visited);
+          free(color);
           return;
         }
         if (color[current_node] == 1)
@@ -140,9 +126,11 @@ void print_bipartite(list_graph_t *graph) {
       } else if (color[current_node] == color[neighbor] &&
                  color[neighbor] != 0) {
         printf("Graph is not bipartite");
+        q_free(q);
+        free(visited);
+        free(color);
         return;
       }
-      curr = curr->next;
     }
   }
   q_free(q);
@@ -150,6 +138,7 @@ void print_bipartite(list_graph_t *graph) {
   for (int i = 0; i < graph->nodes; i++)
     if (color[i] == 0) {
       printf("Graph is not bipartite");
+      free(color);
       return;
     }
   for (int i = 0; i < graph->nodes; i++)
@@ -161,141 +150,75 @@ void print_bipartite(list_graph_t *graph) {
 }
 
 int main() {
-  int n, m, src, dest;
-  list_graph_t *graph;
+  int n, m;
+  int *edges;
+  csr_graph_t *graph;
 
   scanf("%d%d", &n, &m);
 
-  graph = lg_create(n);
+  edges = malloc((2 * (size_t)m + 1) * sizeof(int));
+  DIE(!edges, "malloc edges");
+  for (int i = 0; i < m; ++i) scanf("%d%d", &edges[2 * i], &edges[2 * i + 1]);
 
-  for (int i = 0; i < m; ++i) {
-    scanf("%d%d", &src, &dest);
-    lg_add_edge(graph, src, dest);
-    lg_add_edge(graph, dest, src);
-  }
+  graph = csr_create(n, edges, m, 1);
+  free(edges);
 
   print_bipartite(graph);
-  lg_free(graph);
+  csr_free(graph);
   return 0;
 }
 
 /* Helper data structures functions */
-linked_list_t *ll_create(unsigned int data_size) {
-  linked_list_t *ll = calloc(1, sizeof(*ll));
-  DIE(!ll, "calloc list");
-
-  ll->data_size = data_size;
-
-  return ll;
-}
-
-static ll_node_t *get_nth_node(linked_list_t *list, unsigned int n) {
-  unsigned int len = list->size - 1;
-  unsigned int i;
-  ll_node_t *node = list->head;
-
-  n = MIN(n, len);
-
-  for (i = 0; i < n; ++i) node = node->next;
-
-  return node;
-}
-
-static ll_node_t *create_node(const void *new_data, unsigned int data_size) {
-  ll_node_t *node = calloc(1, sizeof(*node));
-  DIE(!node, "calloc node");
-
-  node->data = malloc(data_size);
-  DIE(!node->data, "malloc data");
-
-  memcpy(node->data, new_data, data_size);
-
-  return node;
-}
-
-void ll_add_nth_node(linked_list_t *list, unsigned int n,
-                     const void *new_data) {
-  ll_node_t *new_node, *prev_node;
-
-  if (!list) return;
-
-  new_node = create_node(new_data, list->data_size);
-
-  if (!n || !list->size) {
-    new_node->next = list->head;
-    list->head = new_node;
-  } else {
-    prev_node = get_nth_node(list, n - 1);
-    new_node->next = prev_node->next;
-    prev_node->next = new_node;
-  }
-
-  ++list->size;
-}
-
-ll_node_t *ll_remove_nth_node(linked_list_t *list, unsigned int n) {
-  ll_node_t *prev_node, *removed_node;
-
-  if (!list || !list->size) return NULL;
-
-  if (!n) {
-    removed_node = list->head;
-    list->head = removed_node->next;
-    removed_node->next = NULL;
-  } else {
-    prev_node = get_nth_node(list, n - 1);
-    removed_node = prev_node->next;
-    prev_node->next = removed_node->next;
-    removed_node->next = NULL;
-  }
-
-  --list->size;
-
-  return removed_node;
-}
-
-unsigned int ll_get_size(linked_list_t *list) { return !list ? 0 : list->size; }
-
-void ll_free(linked_list_t **pp_list) {
-  ll_node_t *node;
-
-  if (!pp_list || !*pp_list) return;
+queue_t *q_create(unsigned int data_size, unsigned int capacity) {
+  queue_t *q = calloc(1, sizeof(*q));
+  unsigned int pow2 = 1;
+  DIE(!q, "calloc queue failed");
 
-  while ((*pp_list)->size) {
-    node = ll_remove_nth_node(*pp_list, 0);
-    free(node->data);
-    free(node);
-  }
+  /* capacity este doar capacitatea initiala, coada creste la nevoie. Se
+   * rotunjeste la o putere a lui 2, ca indecsii sa avanseze prin masca. */
+  while (pow2 < capacity) pow2 <<= 1;
 
-  free(*pp_list);
-  *pp_list = NULL;
-}
+  q->data_size = data_size;
+  q->mask = pow2 - 1;
 
-void ll_print_int(linked_list_t *list) {
-  ll_node_t *node = list->head;
+  q->buff = malloc((size_t)pow2 * data_size);
+  DIE(!q->buff, "malloc buffer failed");
 
-  for (; node; node = node->next) printf("%d ", *(int *)node->data);
-  printf("\n");
+  return q;
 }
 
-void ll_print_string(linked_list_t *list) {
-  ll_node_t *node = list->head;
-
-  for (; node; node = node->next) printf("%s ", (char *)node->data);
-  printf("\n");
+/*
+ * Limiteaza coada la cel mult max_size elemente (0 = fara limita, implicit).
+ * Peste limita, q_enqueue refuza noile elemente. O limita mai mica decat
+ * dimensiunea curenta nu elimina nimic, dar blocheaza adaugarile pana cand
+ * coada scade sub ea.
+ */
+void q_set_max_size(queue_t *q, unsigned int max_size) {
+  if (q) q->max_size = max_size;
 }
 
-queue_t *q_create(unsigned int data_size, unsigned int max_size) {
-  queue_t *q = calloc(1, sizeof(*q));
-  DIE(!q, "calloc queue failed");
-
-  q->data_size = data_size;
-  q->max_size = max_size;
-
-  q->buff = malloc(max_size * sizeof(*q->buff));
-  DIE(!q->buff, "malloc buffer failed");
+/*
+ * Dubleaza capacitatea cozii. Elementele sunt copiate in ordine in noul
+ * buffer, incepand de la pozitia 0, deci coada nu mai este "rupta" la finalul
+ * bufferului.
+ */
+static void q_grow(queue_t *q) {
+  unsigned int capacity = q->mask + 1;
+  unsigned int first = capacity - q->read_idx;
+  char *buff = malloc((size_t)2 * capacity * q->data_size);
+  DIE(!buff, "malloc buffer failed");
+
+  if (first > q->size) first = q->size;
+  memcpy(buff, (char *)q->buff + (size_t)q->read_idx * q->data_size,
+         (size_t)first * q->data_size);
+  memcpy(buff + (size_t)first * q->data_size, q->buff,
+         (size_t)(q->size - first) * q->data_size);
 
-  return q;
+  free(q->buff);
+  q->buff = buff;
+  q->read_idx = 0;
+  q->write_idx = q->size;
+  q->mask = 2 * capacity - 1;
 }
 
 unsigned int q_get_size(queue_t *q) { return !q ? 0 : q->size; }
@@ -305,40 +228,32 @@ unsigned int q_is_empty(queue_t *q) { return !q ? 1 : !q->size; }
 void *q_front(queue_t *q) {
   if (!q || !q->size) return NULL;
 
-  return q->buff[q->read_idx];
+  return (char *)q->buff + (size_t)q->read_idx * q->data_size;
 }
 
 int q_dequeue(queue_t *q) {
   if (!q || !q->size) return 0;
 
-  free(q->buff[q->read_idx]);
-
-  q->read_idx = (q->read_idx + 1) % q->max_size;
+  q->read_idx = (q->read_idx + 1) & q->mask;
   --q->size;
   return 1;
 }
 
 int q_enqueue(queue_t *q, void *new_data) {
-  void *data;
-  if (!q || q->size == q->max_size) return 0;
+  if (!q || (q->max_size && q->size >= q->max_size)) return 0;
 
-  data = malloc(q->data_size);
-  DIE(!data, "malloc data failed");
-  memcpy(data, new_data, q->data_size);
+  if (q->size == q->mask + 1) q_grow(q);
 
-  q->buff[q->write_idx] = data;
-  q->write_idx = (q->write_idx + 1) % q->max_size;
+  memcpy((char *)q->buff + (size_t)q->write_idx * q->data_size, new_data,
+         q->data_size);
+  q->write_idx = (q->write_idx + 1) & q->mask;
   ++q->size;
 
   return 1;
 }
 
 void q_clear(queue_t *q) {
-  unsigned int i;
-  if (!q || !q->size) return;
-
-  for (i = q->read_idx; i != q->write_idx; i = (i + 1) % q->max_size)
-    free(q->buff[i]);
+  if (!q) return;
 
   q->read_idx = 0;
   q->write_idx = 0;
@@ -348,87 +263,62 @@ void q_clear(queue_t *q) {
 void q_free(queue_t *q) {
   if (!q) return;
 
-  q_clear(q);
   free(q->buff);
   free(q);
 }
 
 static int is_node_in_graph(int n, int nodes) { return n >= 0 && n < nodes; }
 
-list_graph_t *lg_create(int nodes) {
-  int i;
-
-  list_graph_t *g = malloc(sizeof(*g));
-  DIE(!g, "malloc graph failed");
-
-  g->neighbors = malloc(nodes * sizeof(*g->neighbors));
-  DIE(!g->neighbors, "malloc neighbours failed");
-
-  for (i = 0; i != nodes; ++i) g->neighbors[i] = ll_create(sizeof(int));
+/*
+ * Construieste graful CSR din cele m muchii edges[2 * i] -> edges[2 * i + 1],
+ * in doua treceri: prima numara gradele, a doua pune fiecare vecin pe pozitia
+ * lui. Vecinii fiecarui nod raman in ordinea din edges. Daca undirected este
+ * nenul, fiecare muchie se adauga in ambele sensuri. Muchiile cu capete in
+ * afara grafului sunt ignorate.
+ */
+csr_graph_t *csr_create(int nodes, const int *edges, int m, int undirected) {
+  csr_graph_t *g = malloc(sizeof(*g));
+  int *pos;
+  DIE(!g, "malloc csr graph failed");
 
   g->nodes = nodes;
+  g->offsets = calloc(nodes + 1, sizeof(int));
+  DIE(!g->offsets, "calloc offsets failed");
 
-  return g;
-}
-
-void lg_add_edge(list_graph_t *graph, int src, int dest) {
-  if (!graph || !graph->neighbors || !is_node_in_graph(src, graph->nodes) ||
-      !is_node_in_graph(dest, graph->nodes))
-    return;
-
-  ll_add_nth_node(graph->neighbors[src], graph->neighbors[src]->size, &dest);
-}
-
-static ll_node_t *find_node(linked_list_t *ll, int node, unsigned int *pos) {
-  ll_node_t *crt = ll->head;
-  unsigned int i;
-
-  for (i = 0; i != ll->size; ++i) {
-    if (node == *(int *)crt->data) {
-      *pos = i;
-      return crt;
-    }
+  for (int i = 0; i < m; ++i) {
+    int src = edges[2 * i], dest = edges[2 * i + 1];
 
-    crt = crt->next;
+    if (!is_node_in_graph(src, nodes) || !is_node_in_graph(dest, nodes))
+      continue;
+    ++g->offsets[src + 1];
+    if (undirected) ++g->offsets[dest + 1];
   }
+  for (int i = 0; i < nodes; ++i) g->offsets[i + 1] += g->offsets[i];
+  g->edges = g->offsets[nodes];
 
-  return NULL;
-}
-
-int lg_has_edge(list_graph_t *graph, int src, int dest) {
-  unsigned int pos;
-
-  if (!graph || !graph->neighbors || !is_node_in_graph(src, graph->nodes) ||
-      !is_node_in_graph(dest, graph->nodes))
-    return 0;
-
-  return find_node(graph->neighbors[src], dest, &pos) != NULL;
-}
-
-linked_list_t *lg_get_neighbours(list_graph_t *graph, int node) {
-  if (!graph || !graph->neighbors || !is_node_in_graph(node, graph->nodes))
-    return NULL;
+  g->targets = malloc((g->edges + 1) * sizeof(int));
+  pos = malloc((nodes + 1) * sizeof(int));
+  DIE(!g->targets || !pos, "malloc targets failed");
+  memcpy(pos, g->offsets, nodes * sizeof(int));
 
-  return graph->neighbors[node];
-}
-
-void lg_remove_edge(list_graph_t *graph, int src, int dest) {
-  unsigned int pos;
+  for (int i = 0; i < m; ++i) {
+    int src = edges[2 * i], dest = edges[2 * i + 1];
 
-  if (!graph || !graph->neighbors || !is_node_in_graph(src, graph->nodes) ||
-      !is_node_in_graph(dest, graph->nodes))
-    return;
+    if (!is_node_in_graph(src, nodes) || !is_node_in_graph(dest, nodes))
+      continue;
+    g->targets[pos[src]++] = dest;
+    if (undirected) g->targets[pos[dest]++] = src;
+  }
 
-  if (!find_node(graph->neighbors[src], dest, &pos)) return;
+  free(pos);
 
-  ll_remove_nth_node(graph->neighbors[src], pos);
+  return g;
 }
 
-void lg_free(list_graph_t *graph) {
-  int i;
-
-  for (i = 0; i != graph->nodes; ++i) ll_free(graph->neighbors + i);
+void csr_free(csr_graph_t *graph) {
+  if (!graph) return;
 
-  free(graph->neighbors);
+  free(graph->offsets);
+  free(graph->targets);
   free(graph);
 }
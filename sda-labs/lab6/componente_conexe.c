@@ -1,9 +1,19 @@
 #include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #define MIN(x, y) ((x) < (y) ? (x) : (y))
+#define MAX(x, y) ((x) > (y) ? (x) : (y))
+
+#define CACHE_LINE 64
+#define WS_DEQUE_INIT_CAPACITY 256
+#define WS_MAX_THREADS 16
 
 #define DIE(assertion, call_description)                 \
   do {                                                   \
@@ -14,76 +24,104 @@
     }                                                    \
   } while (0)
 
-typedef struct ll_node_t ll_node_t;
-typedef struct linked_list_t linked_list_t;
-typedef struct stack_t stack_t;
-typedef struct queue_t queue_t;
-typedef struct list_graph_t list_graph_t;
+typedef struct csr_graph_t csr_graph_t;
+typedef struct ws_array_t ws_array_t;
+typedef struct ws_deque_t ws_deque_t;
+typedef struct ws_worker_t ws_worker_t;
+typedef struct ws_pool_t ws_pool_t;
+typedef void (*ws_task_fn)(ws_worker_t* w, void* ctx, long arg);
 
 /* Helper data structures definitions */
-struct ll_node_t {
-  void* data;
-  ll_node_t* next;
+
+/*
+ * Graf in format CSR (Compressed Sparse Row): vecinii nodului i sunt
+ * targets[offsets[i]], ..., targets[offsets[i + 1] - 1], in ordinea in care
+ * au fost adaugate muchiile. Toate listele de adiacenta stau una dupa alta
+ * in acelasi vector, deci parcurgerea vecinilor este o citire secventiala.
+ */
+struct csr_graph_t {
+  int nodes;
+  int edges;
+  /* nodes + 1 elemente */
+  int* offsets;
+  int* targets;
 };
 
-struct linked_list_t {
-  ll_node_t* head;
-  unsigned int data_size;
-  unsigned int size;
+/*
+ * Deque-ul Chase-Lev pentru work stealing. Proprietarul face push si take la
+ * capatul bottom, fara lock-uri; ceilalti thread-uri fura de la capatul top
+ * cu un CAS. Singura contentie e pentru ultimul element ramas.
+ *
+ * Un task este un long (un nod, un indice sau un pointer convertit). Bufferul
+ * circular creste la nevoie; cel vechi nu poate fi eliberat imediat, fiindca
+ * un hot poate inca citi din el, asa ca ramane in lista retired pana la
+ * ws_deque_free.
+ */
+struct ws_array_t {
+  long mask;
+  ws_array_t* retired;
+  atomic_long buff[];
 };
 
-struct stack_t {
-  struct linked_list_t* list;
+struct ws_deque_t {
+  _Alignas(CACHE_LINE) atomic_long top;
+  _Alignas(CACHE_LINE) atomic_long bottom;
+  _Atomic(ws_array_t*) array;
 };
 
-struct queue_t {
-  unsigned int max_size;
-  unsigned int size;
-  unsigned int data_size;
-  unsigned int read_idx;
-  unsigned int write_idx;
-  void** buff;
+struct ws_worker_t {
+  ws_deque_t deque;
+  /*
+   * Task-uri create cu ws_spawn, respectiv terminate, de acest worker, in
+   * toate joburile de pana acum. Le scrie doar proprietarul, deci nu exista
+   * un contor comun pe care sa-l modifice toate thread-urile la fiecare task.
+   */
+  _Alignas(CACHE_LINE) atomic_long spawned;
+  atomic_long done;
+  ws_pool_t* pool;
+  int id;
+  /* Starea generatorului pentru alegerea victimelor */
+  unsigned int seed;
+  pthread_t thread;
 };
 
-struct list_graph_t {
-  linked_list_t** neighbors;
-  int nodes;
+/*
+ * Pool fix de thread-uri. ws_pool_run porneste un "job": o functie de task si
+ * cateva task-uri radacina; fiecare task poate genera altele cu ws_spawn, pe
+ * deque-ul worker-ului care il executa. Thread-ul care apeleaza ws_pool_run
+ * este worker-ul 0 si se intoarce cand nu mai exista task-uri nerezolvate,
+ * adica roots + suma spawned == suma done (vezi ws_pending).
+ */
+struct ws_pool_t {
+  /* Task-uri radacina primite de ws_pool_run, in toate joburile. */
+  _Alignas(CACHE_LINE) atomic_long roots;
+  ws_task_fn fn;
+  void* ctx;
+
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  /* Creste la fiecare job nou; workerii dorm cat timp nu se schimba. */
+  unsigned int generation;
+  int stop;
+
+  int nthreads;
+  ws_worker_t* workers;
 };
 
-linked_list_t* ll_create(unsigned int data_size);
-static ll_node_t* get_nth_node(linked_list_t* list, unsigned int n);
-void ll_add_nth_node(linked_list_t* list, unsigned int n, const void* new_data);
-ll_node_t* ll_remove_nth_node(linked_list_t* list, unsigned int n);
-unsigned int ll_get_size(linked_list_t* list);
-void ll_free(linked_list_t** pp_list);
-void ll_print_int(linked_list_t* list);
-void ll_print_string(linked_list_t* list);
-
-stack_t* st_create(unsigned int data_size);
-unsigned int st_get_size(stack_t* st);
-unsigned int st_is_empty(stack_t* st);
-void* st_peek(stack_t* st);
-void st_push(stack_t* st, void* new_data);
-void st_pop(stack_t* st);
-void st_clear(stack_t* st);
-void st_free(stack_t* st);
-
-queue_t* q_create(unsigned int data_size, unsigned int max_size);
-unsigned int q_get_size(queue_t* q);
-unsigned int q_is_empty(queue_t* q);
-void* q_front(queue_t* q);
-int q_dequeue(queue_t* q);
-int q_enqueue(queue_t* q, void* new_data);
-void q_clear(queue_t* q);
-void q_free(queue_t* q);
-
-list_graph_t* lg_create(int nodes);
-void lg_add_edge(list_graph_t* graph, int src, int dest);
-static ll_node_t* find_node(linked_list_t* ll, int node, unsigned int* pos);
-int lg_has_edge(list_graph_t* graph, int src, int dest);
-linked_list_t* lg_get_neighbours(list_graph_t* graph, int node);
-void lg_remove_edge(list_graph_t* graph, int src, int dest);
-void lg_free(list_graph_t* graph);
+csr_graph_t* csr_create(int nodes, const int* edges, int m, int undirected);
+void csr_free(csr_graph_t* graph);
+
+void ws_deque_init(ws_deque_t* d);
+void ws_push(ws_deque_t* d, long task);
+int ws_take(ws_deque_t* d, long* task);
+int ws_steal(ws_deque_t* d, long* task);
+void ws_deque_free(ws_deque_t* d);
+
+ws_pool_t* ws_pool_create(int nthreads);
+void ws_spawn(ws_worker_t* w, long task);
+void ws_pool_run(ws_pool_t* pool, ws_task_fn fn, void* ctx, const long* roots,
+                 int n);
+void ws_pool_free(ws_pool_t* pool);
 
 /*
     Output format:
@@ -110,391 +148,570 @@ void lg_free(list_graph_t* graph);
         Order of connected comps DOES matter (start traverals in ascending order
    of nodes, from 0 to N)
 */
-void helper(list_graph_t* graph, int node, int* visited,
-            linked_list_t* all_nodes) {
-  visited[node] = 1;
-  ll_node_t* aux = graph->neighbors[node]->head;
-  int len = graph->neighbors[node]->size;
-  for (int i = 0; i < len; i++) {
-    if (visited[*(int*)(aux->data)] == 0)
-      helper(graph, *(int*)(aux->data), visited, all_nodes);
-    aux = aux->next;
-  }
-  ll_add_nth_node(all_nodes, 10000, &node);
-}
 
-void bfs_list_graph(list_graph_t* lg, int node, int* visited) {
-  queue_t* q = q_create(sizeof(int), lg->nodes);
-  q_enqueue(q, &node);
-  visited[node] = 1;
-  while (!q_is_empty(q)) {
-    int current_node = *(int*)q_front(q);
-    q_dequeue(q);
-    linked_list_t* ll = lg->neighbors[current_node];
-    ll_node_t* curr = ll->head;
-    while (curr != NULL) {
-      int neighbor = *(int*)curr->data;
+/*
+ * DFS din root: pune in order nodurile componentei, fiecare dupa toti vecinii
+ * lui, si intoarce cate sunt. In loc de recursivitate se folosesc stack
+ * (nodurile de pe drumul curent) si next (urmatorul vecin de incercat pentru
+ * fiecare dintre ele), ambele cu loc pentru graph->nodes elemente.
+ */
+static int dfs_postorder(csr_graph_t* graph, int root, int* visited,
+                         int* stack, int* next, int* order) {
+  int top = 0, len = 0;
+
+  visited[root] = 1;
+  stack[0] = root;
+  next[0] = graph->offsets[root];
+
+  while (top >= 0) {
+    int node = stack[top];
+
+    if (next[top] < graph->offsets[node + 1]) {
+      int neighbor = graph->targets[next[top]++];
       if (!visited[neighbor]) {
-        q_enqueue(q, &neighbor);
         visited[neighbor] = 1;
+        ++top;
+        stack[top] = neighbor;
+        next[top] = graph->offsets[neighbor];
       }
-      curr = curr->next;
+    } else {
+      order[len++] = node;
+      --top;
     }
   }
-  q_free(q);
+
+  return len;
 }
 
-void print_connected_components(list_graph_t* graph) {
-  int* visited = calloc(graph->nodes, sizeof(int));
-  int conex = 0;
+/*
+ * Numara componentele conexe cu DFS-ul secvential. Daca order nu este NULL,
+ * pune in el componentele una dupa alta (fiecare in ordinea din
+ * dfs_postorder), iar in lens lungimile lor.
+ */
+int count_connected_components(csr_graph_t* graph, int* order, int* lens) {
+  int* visited = calloc(graph->nodes + 1, sizeof(int));
+  int* stack = malloc((graph->nodes + 1) * sizeof(int));
+  int* next = malloc((graph->nodes + 1) * sizeof(int));
+  int* scratch = order ? NULL : malloc((graph->nodes + 1) * sizeof(int));
+  int conex = 0, total = 0;
+  DIE(!visited || !stack || !next || (!order && !scratch),
+      "malloc dfs buffers");
+
   for (int i = 0; i < graph->nodes; i++) {
     if (visited[i] == 0) {
+      int len = dfs_postorder(graph, i, visited, stack, next,
+                              order ? order + total : scratch);
+      if (lens) lens[conex] = len;
+      total += len;
       conex++;
-      bfs_list_graph(graph, i, visited);
     }
   }
-  free(visited);
-  printf("%d\n", conex);
 
-  linked_list_t* all_nodes = ll_create(sizeof(int));
-  visited = calloc(graph->nodes, sizeof(int));
-  for (int i = 0; i < graph->nodes; i++) {
-    if (visited[i] == 0) {
-      helper(graph, i, visited, all_nodes);
-      ll_print_int(all_nodes);
-      ll_free(&all_nodes);
-      all_nodes = ll_create(sizeof(int));
-    }
-  }
+  free(scratch);
+  free(next);
+  free(stack);
   free(visited);
+
+  return conex;
 }
 
-int main() {
-  int n, m, src, dest;
-  list_graph_t* graph;
+void print_connected_components(csr_graph_t* graph) {
+  int* order = malloc((graph->nodes + 1) * sizeof(int));
+  int* lens = malloc((graph->nodes + 1) * sizeof(int));
+  int conex, pos = 0;
+  DIE(!order || !lens, "malloc components");
 
-  scanf("%d%d", &n, &m);
-  graph = lg_create(n);
+  /* Numarul se afiseaza inaintea componentelor, deci se retin toate. */
+  conex = count_connected_components(graph, order, lens);
+  printf("%d\n", conex);
 
-  // Read graph edges
-  for (int i = 0; i < m; ++i) {
-    scanf("%d%d", &src, &dest);
-    lg_add_edge(graph, src, dest);
-    lg_add_edge(graph, dest, src);
+  for (int c = 0; c < conex; c++) {
+    printf("%d", order[pos]);
+    for (int j = 1; j < lens[c]; j++) printf(" %d", order[pos + j]);
+    printf("\n");
+    pos += lens[c];
   }
 
-  print_connected_components(graph);
-
-  lg_free(graph);
-  return 0;
+  free(lens);
+  free(order);
 }
 
-/* Helper data structures functions */
-linked_list_t* ll_create(unsigned int data_size) {
-  linked_list_t* ll = calloc(1, sizeof(*ll));
-  DIE(!ll, "calloc list");
-
-  ll->data_size = data_size;
+typedef struct {
+  csr_graph_t* graph;
+  /* Cel mai mic nod gasit pana acum in componenta fiecarui nod. */
+  atomic_int* label;
+} cc_ctx_t;
 
-  return ll;
+/*
+ * Task-ul de parcurgere paralela: trimite eticheta nodului la vecini. Fiecare
+ * vecin a carui eticheta scade (CAS) este parcurs mai departe de un task nou,
+ * pe care il poate fura alt worker. Etichetele doar scad, deci la final
+ * fiecare nod are cel mai mic nod din componenta lui.
+ */
+static void cc_propagate(ws_worker_t* w, void* ctx, long node) {
+  cc_ctx_t* c = ctx;
+  csr_graph_t* g = c->graph;
+  int label = atomic_load_explicit(&c->label[node], memory_order_relaxed);
+
+  for (int e = g->offsets[node]; e < g->offsets[node + 1]; ++e) {
+    int neighbor = g->targets[e];
+    int cur = atomic_load_explicit(&c->label[neighbor], memory_order_relaxed);
+
+    while (label < cur) {
+      if (atomic_compare_exchange_weak_explicit(&c->label[neighbor], &cur,
+                                                label, memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        ws_spawn(w, neighbor);
+        break;
+      }
+    }
+  }
 }
 
-static ll_node_t* get_nth_node(linked_list_t* list, unsigned int n) {
-  unsigned int len = list->size - 1;
-  unsigned int i;
-  ll_node_t* node = list->head;
-
-  n = MIN(n, len);
-
-  for (i = 0; i < n; ++i) node = node->next;
-
-  return node;
-}
+/*
+ * Numara componentele conexe cu pool-ul de work stealing: toate nodurile sunt
+ * radacini ale unui singur job, iar componentele sunt nodurile care au ramas
+ * cu propria eticheta.
+ */
+int count_connected_components_parallel(csr_graph_t* graph, ws_pool_t* pool) {
+  cc_ctx_t ctx = {graph, malloc((graph->nodes + 1) * sizeof(atomic_int))};
+  long* roots = malloc((graph->nodes + 1) * sizeof(long));
+  int conex = 0;
+  DIE(!ctx.label || !roots, "malloc labels");
+
+  /*
+   * Proprietarul ia task-urile de la capatul la care au fost puse ultimele,
+   * deci radacinile se pun descrescator: nodul 0 eticheteaza primul intreaga
+   * lui componenta, iar radacinile ajunse deja la eticheta minima nu mai
+   * schimba nimic.
+   */
+  for (int i = 0; i < graph->nodes; i++) {
+    atomic_init(&ctx.label[i], i);
+    roots[i] = graph->nodes - 1 - i;
+  }
 
-static ll_node_t* create_node(const void* new_data, unsigned int data_size) {
-  ll_node_t* node = calloc(1, sizeof(*node));
-  DIE(!node, "calloc node");
+  ws_pool_run(pool, cc_propagate, &ctx, roots, graph->nodes);
 
-  node->data = malloc(data_size);
-  DIE(!node->data, "malloc data");
+  for (int i = 0; i < graph->nodes; i++)
+    conex += atomic_load_explicit(&ctx.label[i], memory_order_relaxed) == i;
 
-  memcpy(node->data, new_data, data_size);
+  free(roots);
+  free(ctx.label);
 
-  return node;
+  return conex;
 }
 
-void ll_add_nth_node(linked_list_t* list, unsigned int n,
-                     const void* new_data) {
-  ll_node_t *new_node, *prev_node;
-
-  if (!list) return;
-
-  new_node = create_node(new_data, list->data_size);
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
 
-  if (!n || !list->size) {
-    new_node->next = list->head;
-    list->head = new_node;
-  } else {
-    prev_node = get_nth_node(list, n - 1);
-    new_node->next = prev_node->next;
-    prev_node->next = new_node;
+/*
+ * Compara DFS-ul secvential cu parcurgerea paralela pe un graf aleator cu n
+ * noduri si n muchii (o componenta mare si multe mici). Se ruleaza cu
+ * ./componente_conexe --bench [n].
+ */
+static void bench(int n) {
+  long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+  int* edges = malloc((2 * (size_t)n + 1) * sizeof(int));
+  csr_graph_t* graph;
+  ws_pool_t* pool;
+  long tasks = 0;
+  int serial, parallel;
+  double t_serial, t_parallel, begin;
+  DIE(!edges, "malloc edges");
+
+  srand(42);
+  for (int i = 0; i < 2 * n; i++) edges[i] = rand() % n;
+  graph = csr_create(n, edges, n, 1);
+  free(edges);
+
+  begin = now();
+  serial = count_connected_components(graph, NULL, NULL);
+  t_serial = now() - begin;
+
+  pool = ws_pool_create(MIN(MAX(nthreads, 1), WS_MAX_THREADS));
+  begin = now();
+  parallel = count_connected_components_parallel(graph, pool);
+  t_parallel = now() - begin;
+  for (int i = 0; i < pool->nthreads; i++)
+    tasks += atomic_load_explicit(&pool->workers[i].done, memory_order_relaxed);
+
+  printf("dfs                  %10d comps  %8.4f s\n", serial, t_serial);
+  printf("parallel, %2d threads %10d comps  %8.4f s  %ld tasks  %s\n",
+         pool->nthreads, parallel, t_parallel, tasks,
+         serial == parallel ? "ok" : "MISMATCH");
+
+  ws_pool_free(pool);
+  csr_free(graph);
+}
+
+int main(int argc, char* argv[]) {
+  int n, m;
+  int* edges;
+  csr_graph_t* graph;
+
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+    bench(argc > 2 ? atoi(argv[2]) : 1 << 20);
+    return 0;
   }
 
-  ++list->size;
-}
-
-ll_node_t* ll_remove_nth_node(linked_list_t* list, unsigned int n) {
-  ll_node_t *prev_node, *removed_node;
+  scanf("%d%d", &n, &m);
 
-  if (!list || !list->size) return NULL;
+  // Read graph edges
+  edges = malloc((2 * (size_t)m + 1) * sizeof(int));
+  DIE(!edges, "malloc edges");
+  for (int i = 0; i < m; ++i) scanf("%d%d", &edges[2 * i], &edges[2 * i + 1]);
 
-  if (!n) {
-    removed_node = list->head;
-    list->head = removed_node->next;
-    removed_node->next = NULL;
-  } else {
-    prev_node = get_nth_node(list, n - 1);
-    removed_node = prev_node->next;
-    prev_node->next = removed_node->next;
-    removed_node->next = NULL;
-  }
+  graph = csr_create(n, edges, m, 1);
+  free(edges);
 
-  --list->size;
+  print_connected_components(graph);
 
-  return removed_node;
+  csr_free(graph);
+  return 0;
 }
 
-unsigned int ll_get_size(linked_list_t* list) { return !list ? 0 : list->size; }
-
-void ll_free(linked_list_t** pp_list) {
-  ll_node_t* node;
+/* Helper data structures functions */
+static int is_node_in_graph(int n, int nodes) { return n >= 0 && n < nodes; }
 
-  if (!pp_list || !*pp_list) return;
+/*
+ * Construieste graful CSR din cele m muchii edges[2 * i] -> edges[2 * i + 1],
+ * in doua treceri: prima numara gradele, a doua pune fiecare vecin pe pozitia
+ * lui. Vecinii fiecarui nod raman in ordinea din edges. Daca undirected este
+ * nenul, fiecare muchie se adauga in ambele sensuri. Muchiile cu capete in
+ * afara grafului sunt ignorate.
+ */
+csr_graph_t* csr_create(int nodes, const int* edges, int m, int undirected) {
+  csr_graph_t* g = malloc(sizeof(*g));
+  int* pos;
+  DIE(!g, "malloc csr graph failed");
 
-  while ((*pp_list)->size) {
-    node = ll_remove_nth_node(*pp_list, 0);
-    free(node->data);
-    free(node);
-  }
+  g->nodes = nodes;
+  g->offsets = calloc(nodes + 1, sizeof(int));
+  DIE(!g->offsets, "calloc offsets failed");
 
-  free(*pp_list);
-  *pp_list = NULL;
-}
+  for (int i = 0; i < m; ++i) {
+    int src = edges[2 * i], dest = edges[2 * i + 1];
 
-void ll_print_int(linked_list_t* list) {
-  ll_node_t* node = list->head;
-  if (node != NULL) {
-    printf("%d", *(int*)node->data);
-    node = node->next;
+    if (!is_node_in_graph(src, nodes) || !is_node_in_graph(dest, nodes))
+      continue;
+    ++g->offsets[src + 1];
+    if (undirected) ++g->offsets[dest + 1];
   }
-  for (; node; node = node->next) printf(" %d", *(int*)node->data);
-  printf("\n");
-}
-
-void ll_print_string(linked_list_t* list) {
-  ll_node_t* node = list->head;
-
-  for (; node; node = node->next) printf("%s ", (char*)node->data);
-  printf("\n");
-}
+  for (int i = 0; i < nodes; ++i) g->offsets[i + 1] += g->offsets[i];
+  g->edges = g->offsets[nodes];
 
-stack_t* st_create(unsigned int data_size) {
-  stack_t* st = malloc(sizeof(*st));
-  DIE(!st, "malloc st failed");
-  st->list = ll_create(data_size);
-  DIE(!st->list, "malloc list failed");
+  g->targets = malloc((g->edges + 1) * sizeof(int));
+  pos = malloc((nodes + 1) * sizeof(int));
+  DIE(!g->targets || !pos, "malloc targets failed");
+  memcpy(pos, g->offsets, nodes * sizeof(int));
 
-  return st;
-}
-
-unsigned int st_get_size(stack_t* st) {
-  if (!st || !st->list) return 0;
-  return st->list->size;
-}
+  for (int i = 0; i < m; ++i) {
+    int src = edges[2 * i], dest = edges[2 * i + 1];
 
-unsigned int st_is_empty(stack_t* st) {
-  return !st || !st->list || !st->list->size;
-}
+    if (!is_node_in_graph(src, nodes) || !is_node_in_graph(dest, nodes))
+      continue;
+    g->targets[pos[src]++] = dest;
+    if (undirected) g->targets[pos[dest]++] = src;
+  }
 
-void* st_peek(stack_t* st) {
-  if (!st || !st->list || !st->list->size) return NULL;
+  free(pos);
 
-  return st->list->head->data;
+  return g;
 }
 
-void st_pop(stack_t* st) {
-  ll_node_t* node;
+void csr_free(csr_graph_t* graph) {
+  if (!graph) return;
 
-  if (!st || !st->list) return;
-
-  node = ll_remove_nth_node(st->list, 0);
-  free(node->data);
-  free(node);
+  free(graph->offsets);
+  free(graph->targets);
+  free(graph);
 }
 
-void st_push(stack_t* st, void* new_data) {
-  if (!st || !st->list) return;
-
-  ll_add_nth_node(st->list, 0, new_data);
-}
+static ws_array_t* ws_array_create(long capacity) {
+  ws_array_t* a = malloc(sizeof(*a) + capacity * sizeof(atomic_long));
+  DIE(!a, "malloc deque array failed");
 
-void st_clear(stack_t* st) {
-  if (!st || !st->list) return;
+  a->mask = capacity - 1;
+  a->retired = NULL;
 
-  ll_free(&st->list);
+  return a;
 }
 
-void st_free(stack_t* st) {
-  if (!st || !st->list) return;
-
-  ll_free(&st->list);
-  free(st);
+void ws_deque_init(ws_deque_t* d) {
+  atomic_init(&d->top, 0);
+  atomic_init(&d->bottom, 0);
+  atomic_init(&d->array, ws_array_create(WS_DEQUE_INIT_CAPACITY));
 }
 
-queue_t* q_create(unsigned int data_size, unsigned int max_size) {
-  queue_t* q = calloc(1, sizeof(*q));
-  DIE(!q, "calloc queue failed");
+/*
+ * Dubleaza bufferul, copiind elementele top..bottom - 1 pe aceleasi pozitii
+ * logice. Doar proprietarul o apeleaza.
+ */
+static ws_array_t* ws_grow(ws_deque_t* d, ws_array_t* a, long top,
+                           long bottom) {
+  ws_array_t* bigger = ws_array_create(2 * (a->mask + 1));
 
-  q->data_size = data_size;
-  q->max_size = max_size;
+  for (long i = top; i < bottom; ++i)
+    atomic_store_explicit(
+        &bigger->buff[i & bigger->mask],
+        atomic_load_explicit(&a->buff[i & a->mask], memory_order_relaxed),
+        memory_order_relaxed);
 
-  q->buff = malloc(max_size * sizeof(*q->buff));
-  DIE(!q->buff, "malloc buffer failed");
+  bigger->retired = a;
+  atomic_store_explicit(&d->array, bigger, memory_order_release);
 
-  return q;
+  return bigger;
 }
 
-unsigned int q_get_size(queue_t* q) { return !q ? 0 : q->size; }
-
-unsigned int q_is_empty(queue_t* q) { return !q ? 1 : !q->size; }
+/* Apelata doar de proprietar: adauga un task la capatul bottom. */
+void ws_push(ws_deque_t* d, long task) {
+  long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+  long t = atomic_load_explicit(&d->top, memory_order_acquire);
+  ws_array_t* a = atomic_load_explicit(&d->array, memory_order_relaxed);
 
-void* q_front(queue_t* q) {
-  if (!q || !q->size) return NULL;
+  if (b - t > a->mask) a = ws_grow(d, a, t, b);
 
-  return q->buff[q->read_idx];
+  atomic_store_explicit(&a->buff[b & a->mask], task, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
 }
 
-int q_dequeue(queue_t* q) {
-  if (!q || !q->size) return 0;
+/*
+ * Apelata doar de proprietar: scoate ultimul task adaugat. Intoarce 0 daca
+ * deque-ul e gol sau ultimul element a fost furat intre timp.
+ */
+int ws_take(ws_deque_t* d, long* task) {
+  long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+  ws_array_t* a = atomic_load_explicit(&d->array, memory_order_relaxed);
+  long t;
+  int ok = 1;
+
+  atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+  if (t > b) {
+    /* Gol */
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return 0;
+  }
 
-  free(q->buff[q->read_idx]);
+  *task = atomic_load_explicit(&a->buff[b & a->mask], memory_order_relaxed);
+  if (t == b) {
+    /* Ultimul element: ne intrecem cu hotii pe top. */
+    ok = atomic_compare_exchange_strong_explicit(
+        &d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+  }
 
-  q->read_idx = (q->read_idx + 1) % q->max_size;
-  --q->size;
-  return 1;
+  return ok;
 }
 
-int q_enqueue(queue_t* q, void* new_data) {
-  void* data;
-  if (!q || q->size == q->max_size) return 0;
+/*
+ * Apelata de orice alt thread: fura cel mai vechi task. Intoarce 0 daca
+ * deque-ul e gol sau alt thread a luat elementul inaintea noastra.
+ */
+int ws_steal(ws_deque_t* d, long* task) {
+  long t = atomic_load_explicit(&d->top, memory_order_acquire);
+  long b;
 
-  data = malloc(q->data_size);
-  DIE(!data, "malloc data failed");
-  memcpy(data, new_data, q->data_size);
+  atomic_thread_fence(memory_order_seq_cst);
+  b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+  if (t >= b) return 0;
 
-  q->buff[q->write_idx] = data;
-  q->write_idx = (q->write_idx + 1) % q->max_size;
-  ++q->size;
+  ws_array_t* a = atomic_load_explicit(&d->array, memory_order_acquire);
+  *task = atomic_load_explicit(&a->buff[t & a->mask], memory_order_relaxed);
 
-  return 1;
+  return atomic_compare_exchange_strong_explicit(
+      &d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
 }
 
-void q_clear(queue_t* q) {
-  unsigned int i;
-  if (!q || !q->size) return;
+void ws_deque_free(ws_deque_t* d) {
+  ws_array_t* a = atomic_load_explicit(&d->array, memory_order_relaxed);
 
-  for (i = q->read_idx; i != q->write_idx; i = (i + 1) % q->max_size)
-    free(q->buff[i]);
-
-  q->read_idx = 0;
-  q->write_idx = 0;
-  q->size = 0;
+  while (a) {
+    ws_array_t* retired = a->retired;
+    free(a);
+    a = retired;
+  }
 }
 
-void q_free(queue_t* q) {
-  if (!q) return;
+/* Cauta un task la ceilalti workeri, incepand cu unul ales aleator. */
+static int ws_steal_any(ws_worker_t* w, long* task) {
+  ws_pool_t* pool = w->pool;
+  int start;
 
-  q_clear(q);
-  free(q->buff);
-  free(q);
-}
+  if (pool->nthreads == 1) return 0;
 
-static int is_node_in_graph(int n, int nodes) { return n >= 0 && n < nodes; }
+  w->seed ^= w->seed << 13;
+  w->seed ^= w->seed >> 17;
+  w->seed ^= w->seed << 5;
+  start = w->seed % pool->nthreads;
 
-list_graph_t* lg_create(int nodes) {
-  int i;
+  for (int i = 0; i < pool->nthreads; ++i) {
+    int victim = (start + i) % pool->nthreads;
+    if (victim != w->id && ws_steal(&pool->workers[victim].deque, task))
+      return 1;
+  }
 
-  list_graph_t* g = malloc(sizeof(*g));
-  DIE(!g, "malloc graph failed");
+  return 0;
+}
 
-  g->neighbors = malloc(nodes * sizeof(*g->neighbors));
-  DIE(!g->neighbors, "malloc neighbours failed");
+/* Incrementeaza un contor pe care il scrie doar thread-ul curent. */
+static inline void ws_count(atomic_long* counter) {
+  atomic_store_explicit(
+      counter, atomic_load_explicit(counter, memory_order_relaxed) + 1,
+      memory_order_release);
+}
 
-  for (i = 0; i != nodes; ++i) g->neighbors[i] = ll_create(sizeof(int));
+/*
+ * Numarul de task-uri nerezolvate. Contoarele done se citesc inaintea celor
+ * spawned: un task vazut ca terminat si-a incrementat spawned pentru fiecare
+ * subtask inainte de done, deci subtask-urile lui sunt deja numarate, iar
+ * rezultatul nu poate fi 0 cat timp mai exista vreun task in lucru.
+ */
+static long ws_pending(ws_pool_t* pool) {
+  long pending = 0;
 
-  g->nodes = nodes;
+  for (int i = 0; i < pool->nthreads; ++i)
+    pending -= atomic_load_explicit(&pool->workers[i].done,
+                                    memory_order_acquire);
+  for (int i = 0; i < pool->nthreads; ++i)
+    pending += atomic_load_explicit(&pool->workers[i].spawned,
+                                    memory_order_acquire);
 
-  return g;
+  return pending + atomic_load_explicit(&pool->roots, memory_order_acquire);
 }
 
-void lg_add_edge(list_graph_t* graph, int src, int dest) {
-  if (!graph || !graph->neighbors || !is_node_in_graph(src, graph->nodes) ||
-      !is_node_in_graph(dest, graph->nodes))
-    return;
-
-  ll_add_nth_node(graph->neighbors[src], graph->neighbors[src]->size, &dest);
+/*
+ * Executa task-uri (proprii sau furate) pana cand nu mai exista niciunul
+ * nerezolvat in jobul curent. Contoarele tuturor workerilor se aduna doar
+ * cand worker-ul nu gaseste de lucru.
+ */
+static void ws_work(ws_worker_t* w) {
+  ws_pool_t* pool = w->pool;
+  long task;
+
+  while (1) {
+    if (ws_take(&w->deque, &task) || ws_steal_any(w, &task)) {
+      pool->fn(w, pool->ctx, task);
+      ws_count(&w->done);
+    } else if (ws_pending(pool) > 0) {
+      sched_yield();
+    } else {
+      break;
+    }
+  }
 }
 
-static ll_node_t* find_node(linked_list_t* ll, int node, unsigned int* pos) {
-  ll_node_t* crt = ll->head;
-  unsigned int i;
+static void* ws_worker_main(void* arg) {
+  ws_worker_t* w = arg;
+  ws_pool_t* pool = w->pool;
+  unsigned int seen = 0;
 
-  for (i = 0; i != ll->size; ++i) {
-    if (node == *(int*)crt->data) {
-      *pos = i;
-      return crt;
+  while (1) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->generation == seen && !pool->stop)
+      pthread_cond_wait(&pool->wake, &pool->lock);
+    seen = pool->generation;
+    if (pool->stop) {
+      pthread_mutex_unlock(&pool->lock);
+      return NULL;
     }
+    pthread_mutex_unlock(&pool->lock);
 
-    crt = crt->next;
+    ws_work(w);
   }
-
-  return NULL;
 }
 
-int lg_has_edge(list_graph_t* graph, int src, int dest) {
-  unsigned int pos;
+ws_pool_t* ws_pool_create(int nthreads) {
+  ws_pool_t* pool = aligned_alloc(CACHE_LINE, sizeof(*pool));
+  DIE(!pool, "aligned_alloc pool failed");
+
+  atomic_init(&pool->roots, 0);
+  pool->fn = NULL;
+  pool->ctx = NULL;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  pool->generation = 0;
+  pool->stop = 0;
+  pool->nthreads = nthreads;
+
+  pool->workers = aligned_alloc(CACHE_LINE, nthreads * sizeof(ws_worker_t));
+  DIE(!pool->workers, "aligned_alloc workers failed");
+
+  for (int i = 0; i < nthreads; ++i) {
+    ws_worker_t* w = &pool->workers[i];
+    ws_deque_init(&w->deque);
+    atomic_init(&w->spawned, 0);
+    atomic_init(&w->done, 0);
+    w->pool = pool;
+    w->id = i;
+    w->seed = 2463534242u + i;
+  }
 
-  if (!graph || !graph->neighbors || !is_node_in_graph(src, graph->nodes) ||
-      !is_node_in_graph(dest, graph->nodes))
-    return 0;
+  /* Worker-ul 0 este thread-ul care apeleaza ws_pool_run. */
+  for (int i = 1; i < nthreads; ++i)
+    DIE(pthread_create(&pool->workers[i].thread, NULL, ws_worker_main,
+                       &pool->workers[i]) != 0,
+        "pthread_create");
 
-  return find_node(graph->neighbors[src], dest, &pos) != NULL;
+  return pool;
 }
 
-linked_list_t* lg_get_neighbours(list_graph_t* graph, int node) {
-  if (!graph || !graph->neighbors || !is_node_in_graph(node, graph->nodes))
-    return NULL;
-
-  return graph->neighbors[node];
+/*
+ * Adauga un subtask pe deque-ul worker-ului curent. Se apeleaza doar din
+ * interiorul unui task, cu w-ul primit ca parametru. spawned creste inainte
+ * ca task-ul sa poata fi furat (ws_push il publica cu release).
+ */
+void ws_spawn(ws_worker_t* w, long task) {
+  ws_count(&w->spawned);
+  ws_push(&w->deque, task);
 }
 
-void lg_remove_edge(list_graph_t* graph, int src, int dest) {
-  unsigned int pos;
-
-  if (!graph || !graph->neighbors || !is_node_in_graph(src, graph->nodes) ||
-      !is_node_in_graph(dest, graph->nodes))
-    return;
-
-  if (!find_node(graph->neighbors[src], dest, &pos)) return;
+/*
+ * Ruleaza fn pe fiecare radacina si pe toate task-urile generate din ele si
+ * se intoarce dupa ce s-au terminat toate.
+ */
+void ws_pool_run(ws_pool_t* pool, ws_task_fn fn, void* ctx, const long* roots,
+                 int n) {
+  ws_worker_t* self = &pool->workers[0];
+
+  if (n <= 0) return;
+
+  pool->fn = fn;
+  pool->ctx = ctx;
+  atomic_fetch_add_explicit(&pool->roots, n, memory_order_release);
+  for (int i = 0; i < n; ++i) ws_push(&self->deque, roots[i]);
+
+  if (pool->nthreads > 1) {
+    pthread_mutex_lock(&pool->lock);
+    ++pool->generation;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+  }
 
-  ll_remove_nth_node(graph->neighbors[src], pos);
+  ws_work(self);
 }
 
-void lg_free(list_graph_t* graph) {
-  int i;
+void ws_pool_free(ws_pool_t* pool) {
+  if (!pool) return;
 
-  for (i = 0; i != graph->nodes; ++i) ll_free(graph->neighbors + i);
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = 1;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
 
-  free(graph->neighbors);
-  free(graph);
+  for (int i = 1; i < pool->nthreads; ++i)
+    pthread_join(pool->workers[i].thread, NULL);
+  for (int i = 0; i < pool->nthreads; ++i)
+    ws_deque_free(&pool->workers[i].deque);
+
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->wake);
+  free(pool->workers);
+  free(pool);
 }
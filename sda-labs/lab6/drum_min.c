@@ -1,10 +1,18 @@
 #include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #define MIN(x, y) ((x) < (y) ? (x) : (y))
 
+#define CACHE_LINE 64
+#define SPSC_CAPACITY 4096
+#define SPSC_BATCH 64
+
 #define DIE(assertion, call_description)                 \
   do {                                                   \
     if (assertion) {                                     \
@@ -14,64 +22,212 @@
     }                                                    \
   } while (0)
 
-#define MAX_QUEUE_SIZE 100
-
-typedef struct ll_node_t ll_node_t;
-typedef struct linked_list_t linked_list_t;
-typedef struct queue_t queue_t;
-typedef struct list_graph_t list_graph_t;
+typedef struct spsc_queue_t spsc_queue_t;
+typedef struct csr_graph_t csr_graph_t;
+typedef struct path_search_t path_search_t;
 
 /* Helper data structures definitions */
-struct ll_node_t {
-  void *data;
-  ll_node_t *next;
-};
 
-struct linked_list_t {
-  ll_node_t *head;
+/*
+ * Coada circulara lock-free pentru exact un producator si un consumator (de
+ * ex. un thread care parseaza intrarea si unul care construieste graful).
+ *
+ * head este scris doar de consumator, tail doar de producator; fiecare sta pe
+ * linia lui de cache, impreuna cu datele private ale thread-ului care il scrie,
+ * ca cele doua thread-uri sa nu-si invalideze reciproc cache-ul. Producatorul
+ * publica elementele scrise (tail, cu release) in loturi de SPSC_BATCH, iar
+ * fiecare parte recitesta indexul celeilalte (cu acquire) doar cand copia
+ * locala spune ca nu mai e loc / nu mai sunt elemente.
+ */
+struct spsc_queue_t {
+  /* Consumator: urmatorul element de citit si ultima valoare vazuta a lui
+   * tail. */
+  _Alignas(CACHE_LINE) atomic_ulong head;
+  unsigned long tail_cache;
+
+  /* Producator: elemente publicate, urmatorul slot de scris si ultima
+   * valoare vazuta a lui head. */
+  _Alignas(CACHE_LINE) atomic_ulong tail;
+  unsigned long write_idx;
+  unsigned long head_cache;
+
+  /* Setat de producator dupa ultimul element. */
+  _Alignas(CACHE_LINE) atomic_int closed;
   unsigned int data_size;
-  unsigned int size;
+  /* Capacitatea (o putere a lui 2) minus 1 */
+  unsigned long mask;
+  char *buff;
 };
 
-struct queue_t {
-  unsigned int max_size;
-  unsigned int size;
-  unsigned int data_size;
-  unsigned int read_idx;
-  unsigned int write_idx;
-  void **buff;
+/*
+ * Graf in format CSR (Compressed Sparse Row): vecinii nodului i sunt
+ * targets[offsets[i]], ..., targets[offsets[i + 1] - 1], in ordinea in care
+ * au fost adaugate muchiile. Toate listele de adiacenta stau una dupa alta
+ * in acelasi vector, deci parcurgerea vecinilor este o citire secventiala.
+ */
+struct csr_graph_t {
+  int nodes;
+  int edges;
+  /* nodes + 1 elemente */
+  int *offsets;
+  int *targets;
 };
 
-struct list_graph_t {
-  linked_list_t **neighbors;
-  int nodes;
+spsc_queue_t *spsc_create(unsigned int data_size, unsigned long capacity);
+int spsc_push(spsc_queue_t *q, const void *new_data);
+void spsc_flush(spsc_queue_t *q);
+void spsc_close(spsc_queue_t *q);
+int spsc_pop(spsc_queue_t *q, void *dst);
+int spsc_is_closed(spsc_queue_t *q);
+void spsc_free(spsc_queue_t *q);
+
+csr_graph_t *csr_create(int nodes, const int *edges, int m, int undirected);
+csr_graph_t *csr_transpose(csr_graph_t *graph);
+void csr_free(csr_graph_t *graph);
+
+static int is_node_in_graph(int n, int nodes);
+
+/*
+ * Cautare de drum minim intre doua noduri, refolosibila: vectorii se aloca o
+ * singura data, la ps_create, iar un nod e vizitat in cautarea curenta doar
+ * daca stamp[side][v] == epoch, deci o cautare noua nu sterge nimic si
+ * lucreaza doar pe nodurile atinse.
+ *
+ * Indicele side este 0 pentru cautarea inainte (din src, pe graph) si 1
+ * pentru cea inapoi (din dest, pe reverse). parent[0][v] este nodul dinaintea
+ * lui v pe drumul src -> v, iar parent[1][v] cel de dupa v pe drumul v -> dest.
+ */
+struct path_search_t {
+  csr_graph_t *graph;
+  /* Graful transpus; daca e NULL se cauta doar inainte */
+  csr_graph_t *reverse;
+  unsigned int epoch;
+  unsigned int *stamp[2];
+  int *parent[2];
+  /* Frontiera curenta a fiecarei parti si cea urmatoare (comuna) */
+  int *frontier[2];
+  int *next;
+  /* Ultimul drum gasit de min_path si cate noduri a atins cautarea */
+  int *path;
+  long visited;
 };
 
-linked_list_t *ll_create(unsigned int data_size);
-static ll_node_t *get_nth_node(linked_list_t *list, unsigned int n);
-void ll_add_nth_node(linked_list_t *list, unsigned int n, const void *new_data);
-ll_node_t *ll_remove_nth_node(linked_list_t *list, unsigned int n);
-unsigned int ll_get_size(linked_list_t *list);
-void ll_free(linked_list_t **pp_list);
-void ll_print_int(linked_list_t *list);
-void ll_print_string(linked_list_t *list);
-
-queue_t *q_create(unsigned int data_size, unsigned int max_size);
-unsigned int q_get_size(queue_t *q);
-unsigned int q_is_empty(queue_t *q);
-void *q_front(queue_t *q);
-int q_dequeue(queue_t *q);
-int q_enqueue(queue_t *q, void *new_data);
-void q_clear(queue_t *q);
-void q_free(queue_t *q);
-
-list_graph_t *lg_create(int nodes);
-void lg_add_edge(list_graph_t *graph, int src, int dest);
-static ll_node_t *find_node(linked_list_t *ll, int node, unsigned int *pos);
-int lg_has_edge(list_graph_t *graph, int src, int dest);
-linked_list_t *lg_get_neighbours(list_graph_t *graph, int node);
-void lg_remove_edge(list_graph_t *graph, int src, int dest);
-void lg_free(list_graph_t *graph);
+path_search_t *ps_create(csr_graph_t *graph, csr_graph_t *reverse) {
+  path_search_t *ps = malloc(sizeof(*ps));
+  int n = graph->nodes ? graph->nodes : 1;
+  DIE(!ps, "malloc path search failed");
+
+  ps->graph = graph;
+  ps->reverse = reverse;
+  ps->epoch = 0;
+  for (int side = 0; side < 2; side++) {
+    ps->stamp[side] = calloc(n, sizeof(unsigned int));
+    ps->parent[side] = malloc(n * sizeof(int));
+    ps->frontier[side] = malloc(n * sizeof(int));
+    DIE(!ps->stamp[side] || !ps->parent[side] || !ps->frontier[side],
+        "malloc path search failed");
+  }
+  ps->next = malloc(n * sizeof(int));
+  ps->path = malloc(n * sizeof(int));
+  DIE(!ps->next || !ps->path, "malloc path search failed");
+
+  return ps;
+}
+
+void ps_free(path_search_t *ps) {
+  if (!ps) return;
+
+  for (int side = 0; side < 2; side++) {
+    free(ps->stamp[side]);
+    free(ps->parent[side]);
+    free(ps->frontier[side]);
+  }
+  free(ps->next);
+  free(ps->path);
+  free(ps);
+}
+
+/*
+ * Pune in ps->path un drum minim de la src la dest si intoarce numarul de
+ * noduri din el (0 daca nu exista drum).
+ *
+ * BFS pe niveluri care se opreste imediat ce drumul e gasit. Cu graful
+ * transpus, cautarea e bidirectionala: la fiecare pas se extinde cu un nivel
+ * partea cu frontiera mai mica, iar primul nod atins de ambele parti da un
+ * drum minim (toate drumurile mai scurte s-ar fi intalnit la un pas
+ * anterior). Se exploreaza astfel doua "bile" de raza ~d/2 in loc de una de
+ * raza d.
+ *
+ * Doar inainte, drumul este exact cel din arborele BFS complet (parintele e
+ * primul nod care l-a descoperit). Cu doua parti, cand exista mai multe
+ * drumuri minime, poate iesi altul de aceeasi lungime.
+ */
+int min_path(path_search_t *ps, int src, int dest) {
+  int size[2] = {1, 1};
+  int meet = -1, len = 0;
+
+  if (!is_node_in_graph(src, ps->graph->nodes) ||
+      !is_node_in_graph(dest, ps->graph->nodes))
+    return 0;
+
+  if (++ps->epoch == 0) {
+    for (int side = 0; side < 2; side++)
+      memset(ps->stamp[side], 0, ps->graph->nodes * sizeof(unsigned int));
+    ps->epoch = 1;
+  }
+
+  ps->stamp[0][src] = ps->epoch;
+  ps->parent[0][src] = -1;
+  ps->frontier[0][0] = src;
+  ps->stamp[1][dest] = ps->epoch;
+  ps->parent[1][dest] = -1;
+  ps->frontier[1][0] = dest;
+  ps->visited = 2;
+  if (src == dest) meet = src;
+
+  while (meet < 0 && size[0] && (!ps->reverse || size[1])) {
+    int side = ps->reverse && size[1] < size[0];
+    csr_graph_t *g = side ? ps->reverse : ps->graph;
+    unsigned int *stamp = ps->stamp[side], *other = ps->stamp[1 - side];
+    int *parent = ps->parent[side], *front = ps->frontier[side];
+    int nn = 0;
+
+    for (int i = 0; i < size[side] && meet < 0; i++) {
+      int node = front[i];
+      for (int e = g->offsets[node]; e < g->offsets[node + 1]; e++) {
+        int neighbor = g->targets[e];
+        if (stamp[neighbor] == ps->epoch) continue;
+        stamp[neighbor] = ps->epoch;
+        parent[neighbor] = node;
+        ps->next[nn++] = neighbor;
+        /* Fara graful transpus, doar dest e marcat de partea inapoi. */
+        if (other[neighbor] == ps->epoch) {
+          meet = neighbor;
+          break;
+        }
+      }
+    }
+
+    ps->frontier[side] = ps->next;
+    ps->next = front;
+    size[side] = nn;
+    ps->visited += nn;
+  }
+
+  if (meet < 0) return 0;
+
+  /* src ... meet, citit invers din parent[0], apoi meet ... dest */
+  for (int v = meet; v != -1; v = ps->parent[0][v]) ps->path[len++] = v;
+  for (int i = 0, j = len - 1; i < j; i++, j--) {
+    int aux = ps->path[i];
+    ps->path[i] = ps->path[j];
+    ps->path[j] = aux;
+  }
+  for (int v = ps->parent[1][meet]; v != -1; v = ps->parent[1][v])
+    ps->path[len++] = v;
+
+  return len;
+}
 
 /*
     TODO
@@ -89,316 +245,333 @@ void lg_free(list_graph_t *graph);
     can be either oriented or unoriented. For this exercise, the graph
     is oriented.
 */
-void print_min_path(list_graph_t *graph, int src, int dest) {
-  int *visited = calloc(graph->nodes, sizeof(int));
-  int *parents = calloc(graph->nodes, sizeof(int));
-  queue_t *q = q_create(sizeof(int), graph->nodes);
-  q_enqueue(q, &src);
-  visited[src] = 1;
-  parents[src] = -1;
-  while (!q_is_empty(q)) {
-    int node = *(int *)q_front(q);
-    q_dequeue(q);
-    linked_list_t *neighbors = lg_get_neighbours(graph, node);
-    ll_node_t *current = neighbors->head;
-    while (current) {
-      int neighbor = *(int *)current->data;
-      if (!visited[neighbor]) {
-        visited[neighbor] = 1;
-        q_enqueue(q, &neighbor);
-        parents[neighbor] = node;
-      }
-      current = current->next;
-    }
-  }
-  int *dist = calloc(graph->nodes, sizeof(int));
-  if (!visited[dest]) {
+void print_min_path(path_search_t *ps, int src, int dest) {
+  int len = min_path(ps, src, dest);
+
+  if (!len) {
     printf("No path found");
     return;
-  } else {
-    int current = dest;
-    int lungime = 0;
-    while (current != -1) {
-      dist[lungime++] = current;
-      current = parents[current];
-    }
-    for (int i = lungime - 1; i >= 0; i--) printf("%d ", dist[i]);
-    printf("\n");
   }
+  for (int i = 0; i < len; i++) printf("%d ", ps->path[i]);
+  printf("\n");
 }
 
-int main() {
-  int n, m, src, dest;
-  list_graph_t *graph;
-
-  scanf("%d%d", &n, &m);
-  graph = lg_create(n);
+typedef struct {
+  spsc_queue_t *edges;
+  int m;
+} parser_arg_t;
 
-  // Read graph edges
-  for (int i = 0; i < m; ++i) {
-    scanf("%d%d", &src, &dest);
-    lg_add_edge(graph, src, dest);
+/*
+ * Thread-ul producator: citeste cele m muchii si le trimite prin coada SPSC
+ * thread-ului care construieste graful.
+ */
+static void *parse_edges(void *arg) {
+  parser_arg_t *p = arg;
+  int edge[2];
+
+  for (int i = 0; i < p->m; ++i) {
+    if (scanf("%d%d", &edge[0], &edge[1]) != 2) break;
+    while (!spsc_push(p->edges, edge)) sched_yield();
   }
+  spsc_close(p->edges);
 
-  // Read src & dest for min path
-  scanf("%d%d", &src, &dest);
-
-  print_min_path(graph, src, dest);
-
-  lg_free(graph);
-  return 0;
+  return NULL;
 }
 
-/* Helper data structures functions */
-linked_list_t *ll_create(unsigned int data_size) {
-  linked_list_t *ll = calloc(1, sizeof(*ll));
-  DIE(!ll, "calloc list");
-
-  ll->data_size = data_size;
-
-  return ll;
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
 }
 
-static ll_node_t *get_nth_node(linked_list_t *list, unsigned int n) {
-  unsigned int len = list->size - 1;
-  unsigned int i;
-  ll_node_t *node = list->head;
-
-  n = MIN(n, len);
-
-  for (i = 0; i < n; ++i) node = node->next;
-
-  return node;
+/* Returneaza 1 daca path[0..len) incepe in src, se termina in dest si
+ * fiecare pereche de noduri consecutive este o muchie. */
+static int path_valid(csr_graph_t *graph, const int *path, int len, int src,
+                      int dest) {
+  if (path[0] != src || path[len - 1] != dest) return 0;
+  for (int i = 0; i + 1 < len; i++) {
+    int found = 0;
+    for (int e = graph->offsets[path[i]];
+         e < graph->offsets[path[i] + 1] && !found; e++)
+      found = graph->targets[e] == path[i + 1];
+    if (!found) return 0;
+  }
+  return 1;
 }
 
-static ll_node_t *create_node(const void *new_data, unsigned int data_size) {
-  ll_node_t *node = calloc(1, sizeof(*node));
-  DIE(!node, "calloc node");
-
-  node->data = malloc(data_size);
-  DIE(!node->data, "malloc data");
+/*
+ * Compara cautarea doar inainte cu cea bidirectionala pe 1000 de perechi
+ * aleatoare, intr-un graf orientat aleator cu n noduri si ~4n muchii. Se
+ * ruleaza cu ./drum_min --bench [n].
+ */
+static void bench(int n) {
+  int m = 4 * n, pairs = 1000, ok = 1;
+  int *edge_list = malloc((2 * (size_t)m + 2) * sizeof(int));
+  csr_graph_t *graph, *reverse;
+  path_search_t *ps[2];
+  long visited[2] = {0, 0};
+  double secs[2] = {0, 0};
+  DIE(!edge_list, "malloc edges");
+
+  srand(42);
+  for (int i = 0; i < 2 * m; i++) edge_list[i] = rand() % n;
+  graph = csr_create(n, edge_list, m, 0);
+  reverse = csr_transpose(graph);
+  free(edge_list);
+  ps[0] = ps_create(graph, NULL);
+  ps[1] = ps_create(graph, reverse);
+
+  for (int p = 0; p < pairs; p++) {
+    int src = rand() % n, dest = rand() % n, len[2];
+
+    for (int k = 0; k < 2; k++) {
+      double begin = now();
+      len[k] = min_path(ps[k], src, dest);
+      secs[k] += now() - begin;
+      visited[k] += ps[k]->visited;
+      if (len[k] && !path_valid(graph, ps[k]->path, len[k], src, dest))
+        ok = 0;
+    }
+    if (len[0] != len[1]) ok = 0;
+  }
 
-  memcpy(node->data, new_data, data_size);
+  printf("forward        %12ld nodes  %8.4f s\n", visited[0], secs[0]);
+  printf("bidirectional  %12ld nodes  %8.4f s  %5.1fx fewer  %s\n",
+         visited[1], secs[1],
+         (double)visited[0] / (visited[1] ? visited[1] : 1),
+         ok ? "ok" : "MISMATCH");
 
-  return node;
+  ps_free(ps[0]);
+  ps_free(ps[1]);
+  csr_free(reverse);
+  csr_free(graph);
 }
 
-void ll_add_nth_node(linked_list_t *list, unsigned int n,
-                     const void *new_data) {
-  ll_node_t *new_node, *prev_node;
-
-  if (!list) return;
-
-  new_node = create_node(new_data, list->data_size);
-
-  if (!n || !list->size) {
-    new_node->next = list->head;
-    list->head = new_node;
-  } else {
-    prev_node = get_nth_node(list, n - 1);
-    new_node->next = prev_node->next;
-    prev_node->next = new_node;
+int main(int argc, char *argv[]) {
+  int n, m, src, dest, read = 0;
+  int *edge_list;
+  csr_graph_t *graph;
+  path_search_t *ps;
+  spsc_queue_t *edges;
+  parser_arg_t parser_arg;
+  pthread_t parser;
+
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+    bench(argc > 2 ? atoi(argv[2]) : 1 << 17);
+    return 0;
   }
 
-  ++list->size;
-}
-
-ll_node_t *ll_remove_nth_node(linked_list_t *list, unsigned int n) {
-  ll_node_t *prev_node, *removed_node;
-
-  if (!list || !list->size) return NULL;
+  scanf("%d%d", &n, &m);
 
-  if (!n) {
-    removed_node = list->head;
-    list->head = removed_node->next;
-    removed_node->next = NULL;
-  } else {
-    prev_node = get_nth_node(list, n - 1);
-    removed_node = prev_node->next;
-    prev_node->next = removed_node->next;
-    removed_node->next = NULL;
+  // Read graph edges: parsed on another thread, collected here
+  edge_list = malloc((2 * (size_t)m + 2) * sizeof(int));
+  DIE(!edge_list, "malloc edges");
+  edges = spsc_create(2 * sizeof(int), SPSC_CAPACITY);
+  parser_arg.edges = edges;
+  parser_arg.m = m;
+  DIE(pthread_create(&parser, NULL, parse_edges, &parser_arg) != 0,
+      "pthread_create");
+
+  while (1) {
+    if (spsc_pop(edges, &edge_list[2 * read])) {
+      read++;
+    } else if (spsc_is_closed(edges)) {
+      /* closed se seteaza dupa ultima publicare: golim ce a ramas. */
+      while (spsc_pop(edges, &edge_list[2 * read])) read++;
+      break;
+    } else {
+      sched_yield();
+    }
   }
 
-  --list->size;
-
-  return removed_node;
-}
-
-unsigned int ll_get_size(linked_list_t *list) { return !list ? 0 : list->size; }
-
-void ll_free(linked_list_t **pp_list) {
-  ll_node_t *node;
+  pthread_join(parser, NULL);
+  spsc_free(edges);
 
-  if (!pp_list || !*pp_list) return;
+  graph = csr_create(n, edge_list, read, 0);
+  free(edge_list);
 
-  while ((*pp_list)->size) {
-    node = ll_remove_nth_node(*pp_list, 0);
-    free(node->data);
-    free(node);
-  }
-
-  free(*pp_list);
-  *pp_list = NULL;
-}
+  // Read src & dest for min path
+  scanf("%d%d", &src, &dest);
 
-void ll_print_int(linked_list_t *list) {
-  ll_node_t *node = list->head;
+  /* Doar inainte, ca drumul afisat sa fie cel din arborele BFS. */
+  ps = ps_create(graph, NULL);
+  print_min_path(ps, src, dest);
 
-  for (; node; node = node->next) printf("%d ", *(int *)node->data);
-  printf("\n");
+  ps_free(ps);
+  csr_free(graph);
+  return 0;
 }
 
-void ll_print_string(linked_list_t *list) {
-  ll_node_t *node = list->head;
+/* Helper data structures functions */
+static int is_node_in_graph(int n, int nodes) { return n >= 0 && n < nodes; }
 
-  for (; node; node = node->next) printf("%s ", (char *)node->data);
-  printf("\n");
-}
+spsc_queue_t *spsc_create(unsigned int data_size, unsigned long capacity) {
+  spsc_queue_t *q = aligned_alloc(CACHE_LINE, sizeof(*q));
+  unsigned long pow2 = 1;
+  DIE(!q, "aligned_alloc spsc queue failed");
 
-queue_t *q_create(unsigned int data_size, unsigned int max_size) {
-  queue_t *q = calloc(1, sizeof(*q));
-  DIE(!q, "calloc queue failed");
+  while (pow2 < capacity) pow2 <<= 1;
 
+  atomic_init(&q->head, 0);
+  atomic_init(&q->tail, 0);
+  atomic_init(&q->closed, 0);
+  q->tail_cache = 0;
+  q->write_idx = 0;
+  q->head_cache = 0;
   q->data_size = data_size;
-  q->max_size = max_size;
+  q->mask = pow2 - 1;
 
-  q->buff = malloc(max_size * sizeof(*q->buff));
-  DIE(!q->buff, "malloc buffer failed");
+  q->buff = malloc(pow2 * data_size);
+  DIE(!q->buff, "malloc spsc buffer failed");
 
   return q;
 }
 
-unsigned int q_get_size(queue_t *q) { return !q ? 0 : q->size; }
-
-unsigned int q_is_empty(queue_t *q) { return !q ? 1 : !q->size; }
-
-void *q_front(queue_t *q) {
-  if (!q || !q->size) return NULL;
-
-  return q->buff[q->read_idx];
-}
+/*
+ * Apelata doar de producator. Scrie elementul in urmatorul slot liber si il
+ * publica la fiecare SPSC_BATCH elemente. Intoarce 0 daca coada e plina (caz
+ * in care publica tot ce era scris, ca sa poata avansa consumatorul).
+ */
+int spsc_push(spsc_queue_t *q, const void *new_data) {
+  if (q->write_idx - q->head_cache > q->mask) {
+    q->head_cache = atomic_load_explicit(&q->head, memory_order_acquire);
+    if (q->write_idx - q->head_cache > q->mask) {
+      spsc_flush(q);
+      return 0;
+    }
+  }
 
-int q_dequeue(queue_t *q) {
-  if (!q || !q->size) return 0;
+  memcpy(q->buff + (q->write_idx & q->mask) * q->data_size, new_data,
+         q->data_size);
+  q->write_idx++;
 
-  free(q->buff[q->read_idx]);
+  if (q->write_idx - atomic_load_explicit(&q->tail, memory_order_relaxed) >=
+      SPSC_BATCH)
+    spsc_flush(q);
 
-  q->read_idx = (q->read_idx + 1) % q->max_size;
-  --q->size;
   return 1;
 }
 
-int q_enqueue(queue_t *q, void *new_data) {
-  void *data;
-  if (!q || q->size == q->max_size) return 0;
-
-  data = malloc(q->data_size);
-  DIE(!data, "malloc data failed");
-  memcpy(data, new_data, q->data_size);
+/* Apelata doar de producator: face vizibile consumatorului toate elementele
+ * scrise pana acum. */
+void spsc_flush(spsc_queue_t *q) {
+  atomic_store_explicit(&q->tail, q->write_idx, memory_order_release);
+}
 
-  q->buff[q->write_idx] = data;
-  q->write_idx = (q->write_idx + 1) % q->max_size;
-  ++q->size;
+/* Apelata doar de producator, dupa ultimul spsc_push. */
+void spsc_close(spsc_queue_t *q) {
+  spsc_flush(q);
+  atomic_store_explicit(&q->closed, 1, memory_order_release);
+}
 
-  return 1;
+int spsc_is_closed(spsc_queue_t *q) {
+  return atomic_load_explicit(&q->closed, memory_order_acquire);
 }
 
-void q_clear(queue_t *q) {
-  unsigned int i;
-  if (!q || !q->size) return;
+/*
+ * Apelata doar de consumator. Copiaza in dst cel mai vechi element publicat si
+ * il scoate din coada. Intoarce 0 daca nu exista niciun element publicat.
+ */
+int spsc_pop(spsc_queue_t *q, void *dst) {
+  unsigned long head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+  if (head == q->tail_cache) {
+    q->tail_cache = atomic_load_explicit(&q->tail, memory_order_acquire);
+    if (head == q->tail_cache) return 0;
+  }
 
-  for (i = q->read_idx; i != q->write_idx; i = (i + 1) % q->max_size)
-    free(q->buff[i]);
+  memcpy(dst, q->buff + (head & q->mask) * q->data_size, q->data_size);
+  atomic_store_explicit(&q->head, head + 1, memory_order_release);
 
-  q->read_idx = 0;
-  q->write_idx = 0;
-  q->size = 0;
+  return 1;
 }
 
-void q_free(queue_t *q) {
+void spsc_free(spsc_queue_t *q) {
   if (!q) return;
 
-  q_clear(q);
   free(q->buff);
   free(q);
 }
 
-static int is_node_in_graph(int n, int nodes) { return n >= 0 && n < nodes; }
-
-list_graph_t *lg_create(int nodes) {
-  int i;
-
-  list_graph_t *g = malloc(sizeof(*g));
-  DIE(!g, "malloc graph failed");
-
-  g->neighbors = malloc(nodes * sizeof(*g->neighbors));
-  DIE(!g->neighbors, "malloc neighbours failed");
-
-  for (i = 0; i != nodes; ++i) g->neighbors[i] = ll_create(sizeof(int));
+/*
+ * Construieste graful CSR din cele m muchii edges[2 * i] -> edges[2 * i + 1],
+ * in doua treceri: prima numara gradele, a doua pune fiecare vecin pe pozitia
+ * lui. Vecinii fiecarui nod raman in ordinea din edges. Daca undirected este
+ * nenul, fiecare muchie se adauga in ambele sensuri. Muchiile cu capete in
+ * afara grafului sunt ignorate.
+ */
+csr_graph_t *csr_create(int nodes, const int *edges, int m, int undirected) {
+  csr_graph_t *g = malloc(sizeof(*g));
+  int *pos;
+  DIE(!g, "malloc csr graph failed");
 
   g->nodes = nodes;
+  g->offsets = calloc(nodes + 1, sizeof(int));
+  DIE(!g->offsets, "calloc offsets failed");
 
-  return g;
-}
-
-void lg_add_edge(list_graph_t *graph, int src, int dest) {
-  if (!graph || !graph->neighbors || !is_node_in_graph(src, graph->nodes) ||
-      !is_node_in_graph(dest, graph->nodes))
-    return;
-
-  ll_add_nth_node(graph->neighbors[src], graph->neighbors[src]->size, &dest);
-}
-
-static ll_node_t *find_node(linked_list_t *ll, int node, unsigned int *pos) {
-  ll_node_t *crt = ll->head;
-  unsigned int i;
-
-  for (i = 0; i != ll->size; ++i) {
-    if (node == *(int *)crt->data) {
-      *pos = i;
-      return crt;
-    }
+  for (int i = 0; i < m; ++i) {
+    int src = edges[2 * i], dest = edges[2 * i + 1];
 
-    crt = crt->next;
+    if (!is_node_in_graph(src, nodes) || !is_node_in_graph(dest, nodes))
+      continue;
+    ++g->offsets[src + 1];
+    if (undirected) ++g->offsets[dest + 1];
   }
+  for (int i = 0; i < nodes; ++i) g->offsets[i + 1] += g->offsets[i];
+  g->edges = g->offsets[nodes];
 
-  return NULL;
-}
-
-int lg_has_edge(list_graph_t *graph, int src, int dest) {
-  unsigned int pos;
+  g->targets = malloc((g->edges + 1) * sizeof(int));
+  pos = malloc((nodes + 1) * sizeof(int));
+  DIE(!g->targets || !pos, "malloc targets failed");
+  memcpy(pos, g->offsets, nodes * sizeof(int));
 
-  if (!graph || !graph->neighbors || !is_node_in_graph(src, graph->nodes) ||
-      !is_node_in_graph(dest, graph->nodes))
-    return 0;
+  for (int i = 0; i < m; ++i) {
+    int src = edges[2 * i], dest = edges[2 * i + 1];
 
-  return find_node(graph->neighbors[src], dest, &pos) != NULL;
-}
+    if (!is_node_in_graph(src, nodes) || !is_node_in_graph(dest, nodes))
+      continue;
+    g->targets[pos[src]++] = dest;
+    if (undirected) g->targets[pos[dest]++] = src;
+  }
 
-linked_list_t *lg_get_neighbours(list_graph_t *graph, int node) {
-  if (!graph || !graph->neighbors || !is_node_in_graph(node, graph->nodes))
-    return NULL;
+  free(pos);
 
-  return graph->neighbors[node];
+  return g;
 }
 
-void lg_remove_edge(list_graph_t *graph, int src, int dest) {
-  unsigned int pos;
-
-  if (!graph || !graph->neighbors || !is_node_in_graph(src, graph->nodes) ||
-      !is_node_in_graph(dest, graph->nodes))
-    return;
-
-  if (!find_node(graph->neighbors[src], dest, &pos)) return;
-
-  ll_remove_nth_node(graph->neighbors[src], pos);
+/*
+ * Graful transpus: vecinii nodului i sunt nodurile care au muchie spre i, in
+ * ordine crescatoare. Se construieste prin numarare, in O(nodes + edges).
+ */
+csr_graph_t *csr_transpose(csr_graph_t *graph) {
+  csr_graph_t *t = malloc(sizeof(*t));
+  int *pos;
+  DIE(!t, "malloc csr graph failed");
+
+  t->nodes = graph->nodes;
+  t->edges = graph->edges;
+  t->offsets = calloc(graph->nodes + 1, sizeof(int));
+  t->targets = malloc((graph->edges + 1) * sizeof(int));
+  pos = malloc((graph->nodes + 1) * sizeof(int));
+  DIE(!t->offsets || !t->targets || !pos, "malloc csr transpose failed");
+
+  for (int e = 0; e < graph->edges; ++e) ++t->offsets[graph->targets[e] + 1];
+  for (int i = 0; i < graph->nodes; ++i) t->offsets[i + 1] += t->offsets[i];
+  memcpy(pos, t->offsets, graph->nodes * sizeof(int));
+
+  for (int i = 0; i < graph->nodes; ++i)
+    for (int e = graph->offsets[i]; e < graph->offsets[i + 1]; ++e)
+      t->targets[pos[graph->targets[e]]++] = i;
+
+  free(pos);
+
+  return t;
 }
 
-void lg_free(list_graph_t *graph) {
-  int i;
-
-  for (i = 0; i != graph->nodes; ++i) ll_free(graph->neighbors + i);
+void csr_free(csr_graph_t *graph) {
+  if (!graph) return;
 
-  free(graph->neighbors);
+  free(graph->offsets);
+  free(graph->targets);
   free(graph);
 }
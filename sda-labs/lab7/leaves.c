@@ -3,7 +3,7 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define MAX_NODES 500
+#define QUEUE_INIT_CAPACITY 64
 #define BUF_SIZ 512
 
 #define DIE(assertion, call_description)                 \
@@ -37,7 +37,8 @@ struct b_tree_t {
 
 /* Helper queue data structure definitions */
 typedef struct queue_t queue_t;
-queue_t *q_create(unsigned int data_size, unsigned int max_size);
+queue_t *q_create(unsigned int data_size, unsigned int capacity);
+void q_set_max_size(queue_t *q, unsigned int max_size);
 unsigned int q_get_size(queue_t *q);
 unsigned int q_is_empty(queue_t *q);
 void *q_front(queue_t *q);
@@ -71,6 +72,8 @@ b_tree_t *b_tree_create(size_t data_size) {
   DIE(tree == NULL, "malloc failed\n");
   tree->root = NULL;
   tree->data_size = data_size;
+
+  return tree;
 }
 
 /**
@@ -91,7 +94,7 @@ void b_tree_insert(b_tree_t *b_tree, void *data) {
     return;
   }
 
-  q = q_create(sizeof(b_node_t *), MAX_NODES);
+  q = q_create(sizeof(b_node_t *), QUEUE_INIT_CAPACITY);
 
   q_enqueue(q, &b_tree->root);
   while (!q_is_empty(q)) {
@@ -111,6 +114,8 @@ void b_tree_insert(b_tree_t *b_tree, void *data) {
       q_enqueue(q, &b_node_tmp->right);
     }
   }
+
+  q_free(q);
 }
 
 /**
@@ -175,24 +180,19 @@ void b_tree_free(b_tree_t *b_tree, void (*free_data)(void *)) {
 
 void read_tree(b_tree_t *b_tree) {
   int i, N, data;
-  char *token;
   char buf[BUF_SIZ];
-  const char delim[2] = " ";
 
   fgets(buf, BUF_SIZ, stdin);
   sscanf(buf, "%d\n", &N);
 
-  fgets(buf, BUF_SIZ, stdin);
+  /* Valorile se citesc una cate una, deci linia poate avea orice lungime. */
   for (i = 0; i < N; ++i) {
-    if (i == 0) {
-      token = strtok(buf, delim);
-    } else {
-      token = strtok(NULL, delim);
-    }
-
-    data = atoi(token);
+    scanf("%d", &data);
     b_tree_insert(b_tree, &data);
   }
+
+  /* Restul liniei cu valori. */
+  fgets(buf, BUF_SIZ, stdin);
 }
 
 void print_data(void *data) { printf("%d ", *(int *)data); }
@@ -256,7 +256,7 @@ int main(void) {
 }
 
 struct queue_t {
-  /* Dimensiunea maxima a cozii */
+  /* Dimensiunea maxima a cozii; 0 inseamna fara limita */
   unsigned int max_size;
   /* Dimensiunea cozii */
   unsigned int size;
@@ -266,23 +266,65 @@ struct queue_t {
   unsigned int read_idx;
   /* Indexul de la care se vor efectua operatiile de enqueue */
   unsigned int write_idx;
-  /* Bufferul ce stocheaza elementele cozii */
-  void **buff;
+  /* Capacitatea bufferului (o putere a lui 2) minus 1 */
+  unsigned int mask;
+  /* Bufferul ce stocheaza elementele cozii, unul dupa altul, cate
+   * data_size octeti fiecare */
+  void *buff;
 };
 
-queue_t *q_create(unsigned int data_size, unsigned int max_size) {
+queue_t *q_create(unsigned int data_size, unsigned int capacity) {
   queue_t *q = calloc(1, sizeof(*q));
+  unsigned int pow2 = 1;
   DIE(!q, "calloc queue failed");
 
+  /* capacity este doar capacitatea initiala, coada creste la nevoie. Se
+   * rotunjeste la o putere a lui 2, ca indecsii sa avanseze prin masca. */
+  while (pow2 < capacity) pow2 <<= 1;
+
   q->data_size = data_size;
-  q->max_size = max_size;
+  q->mask = pow2 - 1;
 
-  q->buff = malloc(max_size * sizeof(*q->buff));
+  q->buff = malloc((size_t)pow2 * data_size);
   DIE(!q->buff, "malloc buffer failed");
 
   return q;
 }
 
+/*
+ * Limiteaza coada la cel mult max_size elemente (0 = fara limita, implicit).
+ * Peste limita, q_enqueue refuza noile elemente. O limita mai mica decat
+ * dimensiunea curenta nu elimina nimic, dar blocheaza adaugarile pana cand
+ * coada scade sub ea.
+ */
+void q_set_max_size(queue_t *q, unsigned int max_size) {
+  if (q) q->max_size = max_size;
+}
+
+/*
+ * Dubleaza capacitatea cozii. Elementele sunt copiate in ordine in noul
+ * buffer, incepand de la pozitia 0, deci coada nu mai este "rupta" la finalul
+ * bufferului.
+ */
+static void q_grow(queue_t *q) {
+  unsigned int capacity = q->mask + 1;
+  unsigned int first = capacity - q->read_idx;
+  char *buff = malloc((size_t)2 * capacity * q->data_size);
+  DIE(!buff, "malloc buffer failed");
+
+  if (first > q->size) first = q->size;
+  memcpy(buff, (char *)q->buff + (size_t)q->read_idx * q->data_size,
+         (size_t)first * q->data_size);
+  memcpy(buff + (size_t)first * q->data_size, q->buff,
+         (size_t)(q->size - first) * q->data_size);
+
+  free(q->buff);
+  q->buff = buff;
+  q->read_idx = 0;
+  q->write_idx = q->size;
+  q->mask = 2 * capacity - 1;
+}
+
 unsigned int q_get_size(queue_t *q) { return !q ? 0 : q->size; }
 
 unsigned int q_is_empty(queue_t *q) { return !q ? 1 : !q->size; }
@@ -290,40 +332,32 @@ unsigned int q_is_empty(queue_t *q) { return !q ? 1 : !q->size; }
 void *q_front(queue_t *q) {
   if (!q || !q->size) return NULL;
 
-  return q->buff[q->read_idx];
+  return (char *)q->buff + (size_t)q->read_idx * q->data_size;
 }
 
 int q_dequeue(queue_t *q) {
   if (!q || !q->size) return 0;
 
-  free(q->buff[q->read_idx]);
-
-  q->read_idx = (q->read_idx + 1) % q->max_size;
+  q->read_idx = (q->read_idx + 1) & q->mask;
   --q->size;
   return 1;
 }
 
 int q_enqueue(queue_t *q, void *new_data) {
-  void *data;
-  if (!q || q->size == q->max_size) return 0;
+  if (!q || (q->max_size && q->size >= q->max_size)) return 0;
 
-  data = malloc(q->data_size);
-  DIE(!data, "malloc data failed");
-  memcpy(data, new_data, q->data_size);
+  if (q->size == q->mask + 1) q_grow(q);
 
-  q->buff[q->write_idx] = data;
-  q->write_idx = (q->write_idx + 1) % q->max_size;
+  memcpy((char *)q->buff + (size_t)q->write_idx * q->data_size, new_data,
+         q->data_size);
+  q->write_idx = (q->write_idx + 1) & q->mask;
   ++q->size;
 
   return 1;
 }
 
 void q_clear(queue_t *q) {
-  unsigned int i;
-  if (!q || !q->size) return;
-
-  for (i = q->read_idx; i != q->write_idx; i = (i + 1) % q->max_size)
-    free(q->buff[i]);
+  if (!q) return;
 
   q->read_idx = 0;
   q->write_idx = 0;
@@ -333,7 +367,6 @@ void q_clear(queue_t *q) {
 void q_free(queue_t *q) {
   if (!q) return;
 
-  q_clear(q);
   free(q->buff);
   free(q);
 }
\ No newline at end of file